@@ -0,0 +1,88 @@
+#ifndef AGGREGATE_INDEX_HPP
+#define AGGREGATE_INDEX_HPP
+
+/*
+ * Materialized aggregates of the leaves of every sub-trie of a trie<T>
+ * (leaf count, weight sum, min, max), so that prefix queries cost
+ * O(depth) instead of a visit of the sub-trie.
+ *
+ * The aggregates live in a side_index, which keeps them along the path
+ * on the mutations made through the index. The Policy chooses what is
+ * stored:
+ *     using value_type = ...;
+ *     static value_type identity();                    // aggregate of no leaves
+ *     static value_type leaf(double w);                // aggregate of one leaf
+ *     static value_type combine(value_type, value_type);
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <vector>
+
+#include "side_index.hpp"
+
+/* policies */
+
+struct leaf_count_policy {
+    using value_type = std::size_t;
+    static value_type identity();
+    static value_type leaf(double w);
+    static value_type combine(value_type a, value_type b);
+};
+
+struct weight_sum_policy {
+    using value_type = double;
+    static value_type identity();
+    static value_type leaf(double w);
+    static value_type combine(value_type a, value_type b);
+};
+
+struct weight_min_policy {
+    using value_type = double;
+    static value_type identity();
+    static value_type leaf(double w);
+    static value_type combine(value_type a, value_type b);
+};
+
+struct weight_max_policy {
+    using value_type = double;
+    static value_type identity();
+    static value_type leaf(double w);
+    static value_type combine(value_type a, value_type b);
+};
+
+/* all of them at once */
+struct subtree_aggregates {
+    std::size_t count;
+    double sum;
+    double min;  // +inf without leaves
+    double max;  // -inf without leaves
+};
+
+struct subtree_aggregates_policy {
+    using value_type = subtree_aggregates;
+    static value_type identity();
+    static value_type leaf(double w);
+    static value_type combine(value_type const& a, value_type const& b);
+};
+
+template <typename T, typename Policy = subtree_aggregates_policy>
+struct aggregate_index : side_index<T, typename Policy::value_type, aggregate_index<T, Policy>> {
+    using value_type = typename Policy::value_type;
+
+    /* constructors */
+    explicit aggregate_index(trie<T>& t);
+
+    /* aggregate of a sub-trie of the indexed trie, or of the sub-trie of a prefix(identity if absent) */
+    value_type get(trie<T> const& sub) const;
+    value_type get(std::vector<T> const& prefix) const;
+
+private:
+    friend struct side_index<T, value_type, aggregate_index<T, Policy>>;
+
+    value_type build(trie<T> const& t);
+    void update_entry(trie<T> const& t);
+};
+
+#endif
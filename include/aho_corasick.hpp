@@ -0,0 +1,105 @@
+#ifndef AHO_CORASICK_HPP
+#define AHO_CORASICK_HPP
+
+/*
+ * Aho-Corasick automaton on the sequences of a trie<T>: finds every
+ * dictionary sequence occurring in a text in one pass, O(text + matches),
+ * instead of calling operator[] at every offset.
+ *
+ * The dictionary sequences are the paths from the root to the leaves
+ * (the root alone, the empty sequence, is never reported), a match gives
+ * the weight of its leaf. The states are the nodes of a flat_trie copy of
+ * the trie(breadth-first order); one BFS computes their failure links
+ * (longest proper suffix that is also a path of the trie) and output links
+ * (next state on the failure chain that is a leaf), so the matches ending
+ * at an offset are found by following the output links only.
+ *
+ * The automaton copies what it needs: the trie can change or be destroyed
+ * after the construction. A scanner keeps the state between the chunks of
+ * a stream, so a match can span two chunks.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flat_trie.hpp"
+
+/* occurrence of a dictionary sequence in a text */
+struct text_match {
+    std::size_t end;     // offset one past its last label
+    std::size_t length;  // number of labels, it starts at end - length
+    double weight;       // weight of its leaf
+};
+
+template <typename T>
+struct aho_corasick {
+    using index_type = std::uint32_t;
+
+    /* scan of a stream given in chunks */
+    struct scanner {
+        /**
+         * Scans the next chunk of the stream
+         * @param f called with a text_match for every match, the offsets
+         *  count from the start of the stream
+         * @return The number of matches in the chunk
+        */
+        template <typename Iterator, typename Callback>
+        std::size_t feed(Iterator first, Iterator last, Callback f);
+
+        /* labels scanned so far */
+        std::size_t offset() const;
+        /* starts a new stream */
+        void reset();
+
+    private:
+        friend struct aho_corasick<T>;
+        explicit scanner(aho_corasick<T> const* a);
+
+        aho_corasick<T> const* m_a;
+        index_type m_state;
+        std::size_t m_offset;
+    };
+
+    /* constructors */
+    aho_corasick();
+    explicit aho_corasick(trie<T> const& dictionary);
+
+    /* every match in a text(any sequence of T with begin() and end()), in order of end */
+    template <typename Sequence, typename Callback>
+    std::size_t scan(Sequence const& text, Callback f) const;
+    template <typename Iterator, typename Callback>
+    std::size_t scan(Iterator first, Iterator last, Callback f) const;
+    template <typename Sequence>
+    std::vector<text_match> find_all(Sequence const& text) const;
+
+    scanner stream() const;
+
+    /* size of the automaton */
+    std::size_t states() const;
+    std::size_t patterns() const;
+    std::size_t bytes() const;
+
+private:
+    static constexpr index_type no_state = flat_trie<T>::no_node;
+
+    /* links of a node of the flat trie */
+    struct state {
+        index_type fail;    // failure link, 0(the root) for the root
+        index_type output;  // next leaf on the failure chain, or no_state
+        index_type depth;   // length of its sequence
+        bool leaf;          // a leaf other than the root
+    };
+
+    index_type step(index_type s, T const& label) const;
+    template <typename Callback>
+    std::size_t report(index_type s, std::size_t end, Callback& f) const;
+
+    flat_trie<T> m_trie;
+    std::vector<state> m_states;
+    std::size_t m_patterns;
+};
+
+#endif
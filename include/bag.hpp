@@ -4,6 +4,15 @@
  * container in this file.
  */
 
+// Instrumentation hooks of bag and trie: they expand to nothing unless
+// src/trie_instrument.cpp is included first
+#ifndef TRIE_COUNT
+#define TRIE_COUNT(counter)
+#endif
+#ifndef TRIE_OP_SCOPE
+#define TRIE_OP_SCOPE(op)
+#endif
+
 // Bag is implemented as a single linked list
 template <typename T>
 struct bag{
@@ -16,6 +25,7 @@ struct bag{
         void pop_front();
         void push_front(T const&);
         void push_back(T const&);
+        bool link_ordered(Node*, T*);
 
     public:
         bag();
@@ -27,6 +37,10 @@ struct bag{
         bag<T>& operator=(bag<T> const&);
         bag<T>& operator=(bag<T>&&);
         bool add_ordered(T const&, T*);
+        bool add_ordered(T&&, T*);
+        bool merge_ordered(bag<T>&, T*);
+        template <typename Merge>
+        void merge_ordered(bag<T>&, T*, Merge);
         void reorder();
         bool operator==(const bag<T>& rhs) const;
         bool operator!=(const bag<T>& rhs) const;
@@ -181,6 +195,8 @@ bool bag<T>::operator==(const bag<T>& rhs) const {
                 ++it2;
             }
         }while(equal && it1 != this->end() && it2 != rhs.end());
+        // One bag can still have elements after the other one ended
+        if(equal && (it1 != this->end() || it2 != rhs.end())) equal = false;
     }
     return equal;
 }
@@ -209,10 +225,12 @@ bool bag<T>::has_one_child() const {
 template <typename T>
 void bag<T>::push_front(T const& val) {
     if (empty()) {
+        TRIE_COUNT(allocations);
         m_front = new Node{val, nullptr};
         m_back = m_front;
         return;
     }
+    TRIE_COUNT(allocations);
     m_front = new Node{val, m_front};
 }
 
@@ -223,6 +241,7 @@ void bag<T>::push_back(T const& val) {
         push_front(val);
         return;
     }
+    TRIE_COUNT(allocations);
     m_back->next = new Node{val, nullptr};
     m_back = m_back->next;
 }
@@ -263,6 +282,7 @@ bool bag<T>::add_ordered(T const& val, T* father){
                     equal_label = true;
                 }else if(*(val.get_label()) < *(ptr->next->val.get_label())){ // If next is >, has to add before it this element
                     added = true;
+                    TRIE_COUNT(allocations);
                     Node* new_next = new Node{val, ptr->next};
                     new_next->val.set_parent(father);
                     ptr->next = new_next;
@@ -288,6 +308,111 @@ bool bag<T>::add_ordered(T const& val, T* father){
     }
 }
 
+/**
+ * Move in order of label a child, without copying its subtree
+ * @param val child to move
+ * @param father the new parent of the child
+ * @return - If child was added or not(same label), in the second case val is lost anyway
+ */
+template <typename T>
+bool bag<T>::add_ordered(T&& val, T* father){
+    TRIE_COUNT(allocations);
+    Node* n = new Node{std::move(val), nullptr};
+    if(!link_ordered(n, father)){
+        delete n;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Link an already allocated node in order of label
+ * @param n node to link
+ * @param father the new parent of the element
+ * @return - If the node was linked or not(same label)
+ */
+template <typename T>
+bool bag<T>::link_ordered(Node* n, T* father){
+    Node** ptr = &m_front;
+    while(*ptr && *((*ptr)->val.get_label()) < *(n->val.get_label())){
+        ptr = &((*ptr)->next);
+    }
+    if(*ptr && *((*ptr)->val.get_label()) == *(n->val.get_label())) return false;
+    n->next = *ptr;
+    *ptr = n;
+    if(!n->next) m_back = n;
+    n->val.set_parent(father);
+    return true;
+}
+
+/**
+ * Move in order all the elements of rhs, relinking its nodes(no copies).
+ * Both bags must be ordered.
+ * @param rhs bag whose elements have to be moved
+ * @param father the new parent of the moved elements
+ * @return - If the bags had no common label; the common ones are left in rhs
+ */
+template <typename T>
+bool bag<T>::merge_ordered(bag<T>& rhs, T* father){
+    bool distinct = true;
+    merge_ordered(rhs, father, [&distinct](T&, T&){ distinct = false; });
+    return distinct;
+}
+
+/**
+ * Move in order the elements of rhs whose label isn't in this, relinking its nodes(no copies).
+ * Both bags must be ordered. For every common label merge(own, other) is called
+ * and the element of rhs is left in rhs.
+ * @param rhs bag whose elements have to be moved
+ * @param father the new parent of the moved elements
+ * @param merge called on the pairs with same label
+ */
+template <typename T>
+template <typename Merge>
+void bag<T>::merge_ordered(bag<T>& rhs, T* father, Merge merge){
+    Node* a = m_front;
+    Node* b = rhs.m_front;
+    Node* front = nullptr;
+    Node* back = nullptr;
+    Node* kept_front = nullptr;
+    Node* kept_back = nullptr;
+    while(a || b){
+        Node* next = nullptr;
+        if(!b || (a && *(a->val.get_label()) < *(b->val.get_label()))){
+            next = a;
+            a = a->next;
+        }else if(a && *(a->val.get_label()) == *(b->val.get_label())){
+            // Common label: merge, the node of rhs stays in rhs
+            merge(a->val, b->val);
+            Node* kept = b;
+            b = b->next;
+            kept->next = nullptr;
+            if(kept_back){
+                kept_back->next = kept;
+            }else{
+                kept_front = kept;
+            }
+            kept_back = kept;
+            continue;
+        }else{
+            next = b;
+            b = b->next;
+            next->val.set_parent(father);
+        }
+        next->next = nullptr;
+        if(back){
+            back->next = next;
+        }else{
+            front = next;
+        }
+        back = next;
+    }
+    m_front = front;
+    m_back = back;
+    rhs.m_front = kept_front;
+    rhs.m_back = kept_back;
+}
+
 /** Update the parent of the elements in the actual bag */
 template <typename T>
 void bag<T>::update_parent(T* parent){
@@ -0,0 +1,160 @@
+#ifndef COMPACT_TRIE_HPP
+#define COMPACT_TRIE_HPP
+
+/*
+ * Compact, read-only layout for tries over a byte alphabet
+ * (trie<char>, trie<signed char>, trie<uint8_t>).
+ *
+ * trie.hpp can't be changed, so this is not a specialization of trie<T>:
+ * it is a separate container built from a trie<T> (or parsed from a .tr
+ * file) that offers the same read API: operator[], max(), leaf iterators
+ * and the stream operators.
+ *
+ * Every node is 16 bytes (weight, children index, children count, kind,
+ * label) and lives in a single array. The children of an internal node are
+ * kept in one of four adaptive node kinds (4, 16, 48, 256 children, as in
+ * an adaptive radix tree) that store 4 byte indices instead of pointers.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+struct compact_trie {
+    static_assert(sizeof(T) == 1, "compact_trie requires a byte-sized label type");
+
+    using index_type = std::uint32_t;
+
+    /* reference to a node (sub-trie) of a compact_trie */
+    struct node_ref {
+        node_ref(compact_trie<T> const* t, index_type n);
+
+        double get_weight() const;
+        T const* get_label() const;
+        bool is_leaf() const;
+        std::size_t children_count() const;
+        std::vector<node_ref> children() const;
+
+        node_ref operator[](std::vector<T> const&) const;
+        node_ref max() const;
+
+        typename compact_trie<T>::const_leaf_iterator begin() const;
+        typename compact_trie<T>::const_leaf_iterator end() const;
+
+        bool operator==(node_ref const&) const;
+        bool operator!=(node_ref const&) const;
+
+    private:
+        friend struct compact_trie<T>;
+        compact_trie<T> const* m_t;
+        index_type m_n;
+    };
+
+    /* leaf iterator, visits the leaves of a sub-trie in lexicographic order */
+    struct const_leaf_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const T;
+        using pointer = T const*;
+        using reference = T const&;
+
+        reference operator*() const;
+        pointer operator->() const;
+        const_leaf_iterator& operator++();
+        const_leaf_iterator operator++(int);
+        bool operator==(const_leaf_iterator const&) const;
+        bool operator!=(const_leaf_iterator const&) const;
+
+        node_ref get_leaf() const;
+
+    private:
+        friend struct compact_trie<T>;
+        const_leaf_iterator(compact_trie<T> const* t, index_type n, bool end);
+        void descend();
+
+        struct frame {
+            index_type node;
+            unsigned pos;
+        };
+
+        compact_trie<T> const* m_t;
+        std::vector<frame> m_stack;  // path from the sub-trie root to the leaf
+    };
+
+    /* constructors */
+    compact_trie();
+    compact_trie(trie<T> const&);
+
+    /* conversion back to the generic layout */
+    trie<T> expand() const;
+
+    /* root of the trie */
+    node_ref root() const;
+
+    /* same read API as trie<T> */
+    node_ref operator[](std::vector<T> const&) const;
+    node_ref max() const;
+    const_leaf_iterator begin() const;
+    const_leaf_iterator end() const;
+
+    bool operator==(compact_trie<T> const&) const;
+    bool operator!=(compact_trie<T> const&) const;
+
+    /* number of nodes and bytes used by the node arrays */
+    std::size_t size() const;
+    std::size_t bytes() const;
+
+private:
+    enum kind : std::uint8_t { leaf_kind, kind4, kind16, kind48, kind256 };
+
+    struct node {
+        double w;            // weight (meaningful for leaves only)
+        index_type c;        // index of the children in the array of its kind
+        std::uint16_t n;     // number of children
+        std::uint8_t k;      // kind of the children array
+        T l;                 // label of the incoming edge
+    };
+
+    struct node4 {
+        std::uint8_t key[4];
+        index_type child[4];
+    };
+
+    struct node16 {
+        std::uint8_t key[16];
+        index_type child[16];
+    };
+
+    struct node48 {
+        std::uint8_t slot[256];  // key -> slot + 1, 0 if absent
+        index_type child[48];
+    };
+
+    struct node256 {
+        index_type child[256];  // 0 if absent (0 is the root, never a child)
+    };
+
+    static std::uint8_t key_of(T l);
+
+    index_type find_child(index_type n, std::uint8_t key) const;
+    index_type child_at(index_type n, unsigned& pos) const;
+    void set_children(index_type n, std::vector<index_type> const& children);
+    void expand_into(index_type n, trie<T>& t) const;
+    bool equal(index_type a, compact_trie<T> const& rhs, index_type b) const;
+
+    std::vector<node> m_nodes;
+    std::vector<node4> m_n4;
+    std::vector<node16> m_n16;
+    std::vector<node48> m_n48;
+    std::vector<node256> m_n256;
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream&, compact_trie<T> const&);
+
+template <typename T>
+std::istream& operator>>(std::istream&, compact_trie<T>&);
+
+#endif
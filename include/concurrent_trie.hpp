@@ -0,0 +1,87 @@
+#ifndef CONCURRENT_TRIE_HPP
+#define CONCURRENT_TRIE_HPP
+
+/*
+ * Read-mostly concurrent trie: readers never lock, one writer at a time.
+ *
+ * The parent pointers of trie<T> don't allow to share nodes between
+ * versions, so the writer keeps two instances (left-right): readers see the
+ * published one, the writer applies its updates to the other one and logs
+ * them. publish() swaps the two instances, waits for the readers that may
+ * still see the old one to leave (epoch-based reclamation: readers only
+ * announce the epoch in which they started) and replays the log on it.
+ * An update costs twice its own cost instead of a copy of the trie, the
+ * price is the memory of the second instance.
+ *
+ * Updates are replayed, so they must be deterministic. An update that
+ * throws is rolled back(the writer instance is copied from the published
+ * one and the log replayed) and is not logged.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+template <typename T>
+struct concurrent_trie {
+    /* pins the published version, it stays valid until the guard is destroyed */
+    struct read_guard {
+        read_guard(read_guard&&);
+        read_guard(read_guard const&) = delete;
+        read_guard& operator=(read_guard const&) = delete;
+        ~read_guard();
+
+        trie<T> const& operator*() const;
+        trie<T> const* operator->() const;
+
+    private:
+        friend struct concurrent_trie<T>;
+        read_guard(concurrent_trie<T> const* owner, unsigned slot, trie<T> const* t);
+
+        concurrent_trie<T> const* m_owner;
+        unsigned m_slot;
+        trie<T> const* m_t;
+    };
+
+    /* constructors */
+    explicit concurrent_trie(trie<T> const& t = trie<T>{}, unsigned max_readers = 128);
+    ~concurrent_trie();
+
+    concurrent_trie(concurrent_trie<T> const&) = delete;
+    concurrent_trie<T>& operator=(concurrent_trie<T> const&) = delete;
+
+    /* readers: lock-free */
+    read_guard read() const;
+
+    /* writer: update() applies and publishes, stage() only applies */
+    void update(std::function<void(trie<T>&)> f);
+    void stage(std::function<void(trie<T>&)> f);
+    void insert(std::vector<T> const& s, double w);
+    void publish();
+    std::size_t pending() const;
+
+private:
+    struct alignas(64) slot {
+        std::atomic<std::uint64_t> epoch;  // 0 when free
+    };
+
+    unsigned pin(std::uint64_t epoch) const;
+    void wait_readers(std::uint64_t epoch) const;
+
+    unsigned m_max_readers;
+    std::unique_ptr<slot[]> m_slots;
+    std::atomic<std::uint64_t> m_epoch;
+    std::unique_ptr<trie<T>> m_left;
+    std::unique_ptr<trie<T>> m_right;
+    std::atomic<trie<T>*> m_front;  // instance seen by the readers
+    trie<T>* m_back;                // instance updated by the writer
+    std::vector<std::function<void(trie<T>&)>> m_log;
+    std::mutex m_write;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DAWG_HPP
+#define DAWG_HPP
+
+/*
+ * Minimized, read-only form of a trie<T>: a directed acyclic word graph
+ * where equal sub-tries(same labels, leaf weights and structure, as
+ * trie<T>::operator==) are stored once.
+ *
+ * minimize() hash-conses the sub-tries bottom up: a state is identified by
+ * the weight of a leaf or by the (label, child state) pairs of an inner
+ * node, so two sub-tries share their state exactly when they are equal.
+ * Sharing needs equal leaf weights: suffixes of a keyset whose leaves all
+ * have the same weight collapse, distinct weights keep the leaves apart.
+ *
+ * States and edges live in two arrays, labels are interned once. A state
+ * can be reached by many paths, so the API walks paths instead of parent
+ * pointers: operator[] and max() follow one path(max() uses the max
+ * weight stored in every state), the leaf iterator keeps its path and
+ * gives the sequence of the leaf with sequence().
+ *
+ * Labels need std::hash<T>. Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+template <typename T>
+struct dawg {
+    using index_type = std::uint32_t;
+
+    struct const_leaf_iterator;
+
+    /* reference to a state, with the label of the edge it was reached by */
+    struct node_ref {
+        double get_weight() const;
+        T const* get_label() const;
+        bool is_leaf() const;
+        std::size_t children_count() const;
+        std::vector<node_ref> children() const;
+
+        node_ref operator[](std::vector<T> const&) const;
+        node_ref max() const;
+        const_leaf_iterator begin() const;
+        const_leaf_iterator end() const;
+
+        /* states are shared: equal sub-tries have the same state */
+        bool operator==(node_ref const&) const;
+        bool operator!=(node_ref const&) const;
+
+    private:
+        friend struct dawg<T>;
+        node_ref(dawg<T> const* d, index_type state, index_type label);
+
+        dawg<T> const* m_d;
+        index_type m_state;
+        index_type m_label;  // no_label for the root
+    };
+
+    /* leaf iterator, visits the leaves(paths) of a sub-trie in lexicographic order */
+    struct const_leaf_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const T;
+        using pointer = T const*;
+        using reference = T const&;
+
+        reference operator*() const;
+        pointer operator->() const;
+        const_leaf_iterator& operator++();
+        const_leaf_iterator operator++(int);
+        bool operator==(const_leaf_iterator const&) const;
+        bool operator!=(const_leaf_iterator const&) const;
+
+        node_ref get_leaf() const;
+        /* labels from the start of the iteration to the leaf */
+        std::vector<T> sequence() const;
+
+    private:
+        friend struct dawg<T>;
+        const_leaf_iterator(dawg<T> const* d, index_type start, index_type label, bool end);
+        void descend();
+
+        struct frame {
+            index_type state;
+            index_type pos;  // edge followed
+        };
+
+        dawg<T> const* m_d;
+        index_type m_start;
+        index_type m_start_label;
+        std::vector<frame> m_stack;  // empty if the start is a leaf
+        bool m_end;
+    };
+
+    /* constructors */
+    dawg();
+    explicit dawg(trie<T> const& t);
+
+    /* conversion back to a trie(shared sub-tries are copied) */
+    trie<T> expand() const;
+
+    /* same read API as trie<T> */
+    node_ref root() const;
+    node_ref operator[](std::vector<T> const&) const;
+    node_ref max() const;
+    const_leaf_iterator begin() const;
+    const_leaf_iterator end() const;
+
+    /* size of the graph */
+    std::size_t states() const;
+    std::size_t edges() const;
+    std::size_t bytes() const;
+
+private:
+    static constexpr index_type no_label = ~index_type{0};
+
+    struct state {
+        double w;          // weight of a leaf
+        double max;        // max weight of the leaves below
+        index_type first;  // first edge
+        index_type count;  // number of edges, 0 for a leaf
+    };
+
+    struct edge {
+        index_type label;
+        index_type target;
+    };
+
+    /* hash of a signature of a state */
+    struct signature_hash {
+        std::size_t operator()(std::vector<std::uint64_t> const& s) const;
+    };
+
+    index_type find_edge(index_type s, T const& label) const;
+    void expand_into(index_type s, trie<T>& t) const;
+
+    std::vector<state> m_states;
+    std::vector<edge> m_edges;  // the edges of a state are contiguous, sorted by label
+    std::vector<T> m_labels;
+    index_type m_root;
+};
+
+/* minimized copy of a trie */
+template <typename T>
+dawg<T> minimize(trie<T> const& t);
+
+#endif
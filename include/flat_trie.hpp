@@ -0,0 +1,73 @@
+#ifndef FLAT_TRIE_HPP
+#define FLAT_TRIE_HPP
+
+/*
+ * Read-only copy of a trie<T> in two arrays, the common part of the
+ * structures that only walk a dictionary(aho_corasick, trie_tokenizer).
+ *
+ * The nodes are numbered in breadth-first order, the root is 0: the
+ * children of a node get consecutive numbers, so its edges are contiguous
+ * and sorted by label, and a step is a binary search in a small
+ * contiguous range instead of a walk of the linked children. A node is
+ * numbered after its parent and after every shallower node, so a BFS of
+ * the copy is a loop on the numbers.
+ *
+ * The copy keeps the labels and the weights of the leaves: the trie can
+ * change or be destroyed afterwards.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Binary search in sorted edges
+ * @param first, count the edges [first, first + count)
+ * @param label_of gives the label of an edge
+ * @return The edge with the label, or first + count if absent
+*/
+template <typename Index, typename T, typename LabelOf>
+Index find_sorted_edge(Index first, Index count, T const& label, LabelOf label_of);
+
+template <typename T>
+struct flat_trie {
+    using index_type = std::uint32_t;
+
+    static constexpr index_type no_node = ~index_type{0};
+
+    struct node {
+        index_type first;  // first edge
+        index_type count;  // number of edges, 0 for a leaf
+        double w;          // weight of the trie node
+    };
+
+    struct edge {
+        T label;
+        index_type target;
+    };
+
+    /* constructors */
+    flat_trie();
+    explicit flat_trie(trie<T> const& t);
+
+    node const& get_node(index_type n) const;
+    edge const& get_edge(index_type e) const;
+    bool is_leaf(index_type n) const;
+    double get_weight(index_type n) const;
+
+    /* child of a node with a label, no_node if absent */
+    index_type child(index_type n, T const& label) const;
+
+    /* size of the copy */
+    std::size_t nodes() const;
+    std::size_t edges() const;
+    std::size_t bytes() const;
+
+private:
+    std::vector<node> m_nodes;
+    std::vector<edge> m_edges;
+};
+
+#endif
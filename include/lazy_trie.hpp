@@ -0,0 +1,148 @@
+#ifndef LAZY_TRIE_HPP
+#define LAZY_TRIE_HPP
+
+/*
+ * Indexed on-disk format and a trie that loads it on demand.
+ *
+ * write_indexed() stores a trie<T> as records of its inner nodes, addressed
+ * by their offset in the file; each record holds the weight of the node
+ * and, for every child, its label, the offset of its record, the max
+ * weight of its leaves and if it is a leaf. A leaf has no record: its
+ * entry in the parent already holds its weight(the max), and the offset
+ * of the entry itself identifies the leaf.
+ * Children are written before their parent, the header points to the root:
+ *     header: "TRI2", root offset(uint64), root max(double), root is leaf(uint8)
+ *     record: weight(double), children(uint32), then for each child
+ *             label, offset(uint64), max(double), is leaf(uint8)
+ *     label:  the bytes of a trivially copyable T; for std::string its
+ *             length(uint32) and characters; otherwise the length(uint32)
+ *             and the text of operator<<(max_digits10 digits)
+ * Numbers are in the byte order of the machine that wrote the file.
+ *
+ * lazy_trie opens such a file reading only the header: records are read
+ * when a node is visited and kept in an LRU cache with a bounded number of
+ * records, so memory follows the working set. operator[], max() and the
+ * leaf iterators have the semantics of trie<T>; max() follows the max of
+ * the children, reading only the records on one path.
+ *
+ * Not thread safe(the cache changes on reads). Include it after src/trie.cpp.
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Writes a trie in the indexed format
+ * @param os a seekable binary stream(the header is written last)
+ */
+template <typename T>
+std::ostream& write_indexed(std::ostream& os, trie<T> const& t);
+
+template <typename T>
+struct lazy_trie {
+    /* child entry of a record */
+    struct child_entry {
+        std::shared_ptr<T const> label;
+        std::uint64_t offset;
+        double max;  // max weight of its leaves(its weight for a leaf)
+        bool leaf;
+    };
+
+    /* record of a node */
+    struct record {
+        double weight;
+        std::vector<child_entry> children;  // sorted by label
+    };
+
+    struct const_leaf_iterator;
+
+    /* reference to a node, its record is read when needed */
+    struct node_ref {
+        double get_weight() const;
+        T const* get_label() const;
+        bool is_leaf() const;
+        std::size_t children_count() const;
+        std::vector<node_ref> children() const;
+
+        node_ref operator[](std::vector<T> const&) const;
+        node_ref max() const;
+        const_leaf_iterator begin() const;
+        const_leaf_iterator end() const;
+
+        /* loads the whole sub-trie */
+        trie<T> materialize() const;
+
+    private:
+        friend struct lazy_trie<T>;
+        node_ref(lazy_trie<T> const* t, child_entry const& e);
+
+        lazy_trie<T> const* m_t;
+        child_entry m_entry;
+    };
+
+    /* leaf iterator, visits the leaves of a sub-trie in lexicographic order */
+    struct const_leaf_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const T;
+        using pointer = T const*;
+        using reference = T const&;
+
+        reference operator*() const;
+        pointer operator->() const;
+        const_leaf_iterator& operator++();
+        const_leaf_iterator operator++(int);
+        bool operator==(const_leaf_iterator const&) const;
+        bool operator!=(const_leaf_iterator const&) const;
+
+        node_ref get_leaf() const;
+
+    private:
+        friend struct lazy_trie<T>;
+        const_leaf_iterator(lazy_trie<T> const* t, child_entry const& start, bool end);
+        void descend();
+
+        struct frame {
+            std::shared_ptr<record const> node;  // keeps the labels alive if evicted
+            std::size_t pos;
+        };
+
+        lazy_trie<T> const* m_t;
+        child_entry m_start;         // root of the visited sub-trie
+        std::vector<frame> m_stack;  // path to the leaf(empty if the sub-trie is a leaf)
+        bool m_end;
+    };
+
+    /* constructors */
+    explicit lazy_trie(std::string const& path, std::size_t cache_records = 4096);
+
+    lazy_trie(lazy_trie<T> const&) = delete;
+    lazy_trie<T>& operator=(lazy_trie<T> const&) = delete;
+
+    /* same read API as trie<T> */
+    node_ref root() const;
+    node_ref operator[](std::vector<T> const&) const;
+    node_ref max() const;
+    const_leaf_iterator begin() const;
+    const_leaf_iterator end() const;
+
+    /* cache statistics */
+    std::size_t cached() const;
+    std::size_t reads() const;
+
+private:
+    std::shared_ptr<record const> load(std::uint64_t offset) const;
+
+    mutable std::ifstream m_file;
+    child_entry m_root;
+    std::size_t m_capacity;
+    mutable std::list<std::uint64_t> m_lru;  // most recent first
+    mutable std::unordered_map<std::uint64_t, std::pair<std::shared_ptr<record const>, std::list<std::uint64_t>::iterator>> m_cache;
+    mutable std::size_t m_reads;
+};
+
+#endif
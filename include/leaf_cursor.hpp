@@ -0,0 +1,79 @@
+#ifndef LEAF_CURSOR_HPP
+#define LEAF_CURSOR_HPP
+
+/*
+ * Enumeration of the (sequence, weight) pairs of the leaves of a trie<T>,
+ * in lexicographic order, generator style:
+ *     leaf_cursor<T> c{t};
+ *     while(c.next()) use(c.sequence(), c.weight());
+ *
+ * The leaf iterators give only the last label of a leaf, rebuilding its
+ * sequence means climbing the parents and filling a new vector. The
+ * cursor keeps the path from the root instead: one frame per node(the
+ * next child to visit) and the labels in a buffer, so a step only pops
+ * the labels below the common prefix and pushes the new ones, amortised
+ * O(1) per leaf. The buffers keep their slots: after the first leaves no
+ * step allocates(labels are assigned in place, a std::string keeps its
+ * capacity).
+ *
+ * The sequence is a view on the buffer, valid until the next call to
+ * next(). The trie must not change while a cursor walks it.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <vector>
+
+/* read-only view of a contiguous sequence of labels(std::span is C++20) */
+template <typename T>
+struct sequence_view {
+    T const* data;
+    std::size_t size;
+
+    T const* begin() const;
+    T const* end() const;
+    T const& operator[](std::size_t i) const;
+    bool empty() const;
+    /* copy of the labels */
+    std::vector<T> to_vector() const;
+};
+
+template <typename T>
+struct leaf_cursor {
+    /* constructors */
+    explicit leaf_cursor(trie<T> const& t);
+
+    /**
+     * Moves to the next leaf(the first one on the first call)
+     * @return If there is one
+    */
+    bool next();
+    /* starts again from the first leaf */
+    void reset();
+
+    /* the current leaf, valid after next() returned true */
+    sequence_view<T> sequence() const;
+    double weight() const;
+    trie<T> const& leaf() const;
+    /* labels from the root to the current leaf */
+    std::size_t depth() const;
+
+private:
+    using children_iterator = typename bag<trie<T>>::const_iterator;
+
+    struct frame {
+        trie<T> const* node;
+        children_iterator next;  // next child to visit
+    };
+
+    void push(trie<T> const& child);
+    void descend();
+
+    trie<T> const* m_root;
+    std::vector<frame> m_stack;  // path from the root to the current leaf
+    std::vector<T> m_labels;     // its labels in the first m_stack.size() - 1 slots
+    bool m_started;
+};
+
+#endif
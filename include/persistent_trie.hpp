@@ -0,0 +1,109 @@
+#ifndef PERSISTENT_TRIE_HPP
+#define PERSISTENT_TRIE_HPP
+
+/*
+ * Persistent trie: immutable, reference-counted nodes shared between
+ * versions.
+ *
+ * Copying a persistent_trie is O(1) (a snapshot shares the whole trie),
+ * insert() and set_weight() return a new version that copies only the
+ * nodes on the root-to-leaf path and shares the rest with the old one,
+ * which stays valid and unchanged. A copied node copies its vector of
+ * children pointers, so an update costs O(depth * fan-out) pointer copies
+ * (reference count increments), not O(depth): cheap for the usual small
+ * fan-outs, linear in the width of a wide node on the path.
+ *
+ * Building, updating, comparing, expanding and destroying a version use
+ * explicit stacks(the deleter of the nodes releases the children
+ * iteratively), so long chains don't overflow the stack.
+ *
+ * A shared node can have many parents, so nodes don't store one: upward
+ * navigation goes through a cursor, which keeps the path from the root.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <memory>
+#include <vector>
+
+template <typename T>
+struct persistent_trie {
+    struct node;
+    using node_ptr = std::shared_ptr<node const>;
+
+    /* navigation on a version, keeps the path from the root */
+    struct cursor {
+        explicit cursor(persistent_trie<T> const& t);
+
+        double get_weight() const;
+        T const* get_label() const;
+        bool is_leaf() const;
+        std::size_t children_count() const;
+        std::size_t depth() const;
+        std::vector<T> sequence() const;
+
+        bool down(T const& label);
+        bool down_first();
+        bool next_sibling();
+        bool up();
+
+    private:
+        node const& current() const;
+
+        node_ptr m_root;                      // keeps the version alive
+        std::vector<node const*> m_path;      // from the root to the current node
+        std::vector<std::size_t> m_position;  // index of each node of the path in its parent
+    };
+
+    /* constructors, copies are snapshots */
+    persistent_trie();
+    persistent_trie(double w);
+    explicit persistent_trie(trie<T> const& t);
+
+    /* versioned updates */
+    persistent_trie<T> insert(std::vector<T> const& s, double w) const;
+    persistent_trie<T> set_weight(std::vector<T> const& s, double w) const;
+
+    /* read API */
+    bool contains(std::vector<T> const& s) const;
+    double get_weight(std::vector<T> const& s) const;
+    cursor root() const;
+    std::size_t size() const;
+
+    /* conversion back to the generic layout */
+    trie<T> expand() const;
+
+    bool operator==(persistent_trie<T> const&) const;
+    bool operator!=(persistent_trie<T> const&) const;
+
+    struct node {
+        std::shared_ptr<T const> label;   // nullptr for the root
+        double w;
+        std::vector<node_ptr> children;   // sorted by label
+    };
+
+private:
+    explicit persistent_trie(node_ptr root);
+
+    /* releases the children of a node without recursion */
+    struct node_deleter {
+        void operator()(node const* n) const;
+    };
+
+    static node_ptr make_node(node&& n);
+    static node_ptr build(trie<T> const& t);
+    static node_ptr chain(std::vector<T> const& s, std::size_t i, double w);
+    static node_ptr copy_path(node const& root, std::vector<T> const& s, double w, bool insert);
+    static node const* find(node const* n, std::vector<T> const& s);
+    static std::size_t lower_bound(node const& n, T const& label);
+    static std::size_t count(node const& n);
+    static void expand_into(node const& n, trie<T>& t);
+    static bool equal(node const& a, node const& b);
+
+    node_ptr m_root;
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream&, persistent_trie<T> const&);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SHARDED_TRIE_HPP
+#define SHARDED_TRIE_HPP
+
+/*
+ * Trie for concurrent ingestion: sequences are partitioned on their first
+ * label into shards, each one a trie<T> with its own lock, so producers
+ * inserting sequences with different first labels don't contend.
+ * The shards hold disjoint sets of first labels, so together they are the
+ * children of one merged root: operator[], max() and the leaf iterators
+ * work on the whole keyspace, and freeze() relinks the children of every
+ * shard under a single trie<T> without copying them.
+ * The merged root isn't a node, so where trie<T> would return the root
+ * (operator[] of an empty sequence or of a missing first label, max() of
+ * an empty trie) the sharded trie throws parser_exception instead.
+ *
+ * insert(), contains() and get_weight() lock the shard and can run
+ * concurrently; the merged view (operator[], max(), iterators) doesn't lock
+ * and is meant for when the producers are done.
+ * All the sequences sharing a first label go to the same shard.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+template <typename T>
+struct sharded_trie {
+    /* leaf iterator on the merged view, visits the leaves in lexicographic order */
+    struct const_leaf_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const T;
+        using pointer = T const*;
+        using reference = T const&;
+
+        reference operator*() const;
+        pointer operator->() const;
+        const_leaf_iterator& operator++();
+        const_leaf_iterator operator++(int);
+        bool operator==(const_leaf_iterator const&) const;
+        bool operator!=(const_leaf_iterator const&) const;
+
+        trie<T> const& get_leaf() const;
+
+    private:
+        friend struct sharded_trie<T>;
+        const_leaf_iterator(std::shared_ptr<std::vector<trie<T> const*> const> roots, std::size_t next);
+        void descend(trie<T> const* t);
+
+        struct frame {
+            typename bag<trie<T>>::const_iterator it;
+            typename bag<trie<T>>::const_iterator end;
+        };
+
+        std::shared_ptr<std::vector<trie<T> const*> const> m_roots;  // children of the merged root
+        std::size_t m_next;                                          // next child of the merged root
+        std::vector<frame> m_stack;                                  // siblings still to visit
+        trie<T> const* m_leaf;
+    };
+
+    /* constructors */
+    explicit sharded_trie(unsigned shards = 64);
+
+    sharded_trie(sharded_trie<T> const&) = delete;
+    sharded_trie<T>& operator=(sharded_trie<T> const&) = delete;
+
+    /* thread safe */
+    void insert(std::vector<T> const& s, double w);
+    bool contains(std::vector<T> const& s) const;
+    double get_weight(std::vector<T> const& s) const;
+
+    /* merged view, not synchronized with insert() */
+    trie<T> const& operator[](std::vector<T> const&) const;
+    trie<T> const& max() const;
+    const_leaf_iterator begin() const;
+    const_leaf_iterator end() const;
+
+    /* number of shards */
+    std::size_t shards() const;
+
+    /* moves every shard into one trie, the sharded trie is left empty */
+    trie<T> freeze();
+
+private:
+    struct alignas(64) shard {
+        mutable std::mutex lock;
+        trie<T> t;
+    };
+
+    shard& shard_of(T const& label) const;
+    trie<T> const* find(std::vector<T> const& s) const;
+
+    unsigned m_count;
+    std::unique_ptr<shard[]> m_shards;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SIDE_INDEX_HPP
+#define SIDE_INDEX_HPP
+
+/*
+ * Common part of the indexes that cache a value per inner node of a
+ * trie<T>(weight_index, aggregate_index, hash_index).
+ *
+ * trie.hpp can't carry extra members, so the values live in a side table
+ * keyed by the address of the node: a trie that isn't indexed doesn't pay
+ * anything, and the trie must not be moved while indexed. side_index keeps
+ * the table coherent on the mutations made through it (add_child,
+ * set_weight, operator+=, path_compress); after other changes below a node
+ * call refresh() on it, or rebuild().
+ *
+ * The index derives from side_index<T, Entry, Index> and gives it:
+ *     void build(trie<T> const& t);         // entries of a whole sub-trie
+ *     void update_entry(trie<T> const& t);  // entry of t from its children
+ * update_entry is called on inner nodes only, from the children up, so the
+ * entries of the children are already correct.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <unordered_map>
+#include <vector>
+
+template <typename T, typename Entry, typename Index>
+struct side_index {
+    /* constructors */
+    explicit side_index(trie<T>& t);
+
+    trie<T> const& get_trie() const;
+
+    /* mutations keeping the entries correct */
+    void add_child(trie<T>& parent, trie<T> const& child);
+    void set_weight(trie<T>& leaf, double w);
+    Index& operator+=(trie<T> const& rhs);
+    void path_compress();
+    void refresh(trie<T> const& sub);
+    void rebuild();
+
+protected:
+    /* entry of an inner node, nullptr if it isn't indexed */
+    Entry const* find(trie<T> const& t) const;
+    void forget(trie<T> const& t);
+    void update_path(trie<T> const& t);
+
+    trie<T>* m_t;
+    std::unordered_map<trie<T> const*, Entry> m_entries;  // inner nodes only
+
+private:
+    Index& self();
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+/*
+ * Work-stealing thread pool used by the parallel algorithms on trie<T>.
+ * Header-only, like bag.hpp.
+ *
+ * Every worker owns a deque: tasks submitted from inside a task go to the
+ * deque of the worker running it (and are popped LIFO, so a worker keeps
+ * descending its own subtree), idle workers steal the oldest task of the
+ * others. wait() blocks until every submitted task (included the ones
+ * submitted by other tasks) is done, helping to run them meanwhile.
+ *
+ * A task_group counts only the tasks submitted through it: an algorithm
+ * waits its own tasks with it, while other work shares the pool.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct thread_pool {
+    explicit thread_pool(unsigned threads = 0);
+    ~thread_pool();
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    unsigned size() const;
+    void submit(std::function<void()> task);
+    void wait();
+
+private:
+    friend struct task_group;
+
+    struct queue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop_task(std::function<void()>& task, unsigned self);
+    void run_task(std::function<void()>& task);
+    void work(unsigned self);
+
+    static thread_pool*& current_pool();
+    static unsigned& current_index();
+
+    std::vector<std::unique_ptr<queue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<std::size_t> m_queued;   // tasks waiting in a deque
+    std::atomic<std::size_t> m_pending;  // tasks waiting or running
+    std::atomic<unsigned> m_next;        // round robin for external submits
+    bool m_stop;
+    std::mutex m_sleep;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+};
+
+struct task_group {
+    explicit task_group(thread_pool& pool);
+    ~task_group();
+
+    task_group(task_group const&) = delete;
+    task_group& operator=(task_group const&) = delete;
+
+    thread_pool& pool() const;
+    void submit(std::function<void()> task);
+    void wait();
+
+private:
+    void finish(std::exception_ptr error);
+
+    thread_pool& m_pool;
+    std::size_t m_pending;  // tasks of the group waiting or running
+    std::mutex m_lock;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+};
+
+/**
+ * Starts the workers
+ * @param threads number of workers, 0 to use the hardware concurrency
+ */
+inline thread_pool::thread_pool(unsigned threads)
+    : m_queues(), m_workers(), m_queued(0), m_pending(0), m_next(0), m_stop(false), m_sleep(), m_wake(), m_done(), m_error(){
+    if(threads == 0) threads = std::thread::hardware_concurrency();
+    if(threads == 0) threads = 1;
+    for(unsigned i = 0; i < threads; ++i){
+        this->m_queues.push_back(std::unique_ptr<queue>{new queue{}});
+    }
+    for(unsigned i = 0; i < threads; ++i){
+        this->m_workers.emplace_back([this, i]{ this->work(i); });
+    }
+}
+
+/** Waits the submitted tasks and joins the workers */
+inline thread_pool::~thread_pool(){
+    try{
+        this->wait();
+    }catch(...){
+        // Errors not collected by a wait() are dropped
+    }
+    {
+        std::lock_guard<std::mutex> lock{this->m_sleep};
+        this->m_stop = true;
+    }
+    this->m_wake.notify_all();
+    for(auto& w : this->m_workers) w.join();
+}
+
+/** Returns the number of workers */
+inline unsigned thread_pool::size() const{
+    // The deques are all created before the workers start
+    return static_cast<unsigned>(this->m_queues.size());
+}
+
+/**
+ * Schedules a task.
+ * From a worker of this pool the task goes in its own deque.
+ * @param task the task to run
+ */
+inline void thread_pool::submit(std::function<void()> task){
+    unsigned target = 0;
+    if(current_pool() == this){
+        target = current_index();
+    }else{
+        target = this->m_next.fetch_add(1) % this->size();
+    }
+    // Count the task before it can be popped, so the counters never go below zero
+    this->m_pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock{this->m_sleep};
+        this->m_queued.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock{this->m_queues[target]->lock};
+        this->m_queues[target]->tasks.push_back(std::move(task));
+    }
+    this->m_wake.notify_one();
+}
+
+/**
+ * Waits until no task is pending, running tasks meanwhile.
+ * Must not be called from a task.
+ * Rethrows the first exception thrown by a task.
+ */
+inline void thread_pool::wait(){
+    std::function<void()> task;
+    while(this->m_pending.load() > 0){
+        if(this->pop_task(task, this->size())){
+            this->run_task(task);
+        }else{
+            std::unique_lock<std::mutex> lock{this->m_sleep};
+            this->m_done.wait(lock, [this]{ return this->m_pending.load() == 0 || this->m_queued.load() > 0; });
+        }
+    }
+    std::exception_ptr error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{this->m_sleep};
+        std::swap(error, this->m_error);
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+/**
+ * Takes a task: the newest one of its own deque, otherwise the oldest one of another deque
+ * @param task where the task is moved
+ * @param self index of the worker(size() for a thread outside the pool)
+ * @return If a task was found
+ */
+inline bool thread_pool::pop_task(std::function<void()>& task, unsigned self){
+    unsigned n = this->size();
+    if(self < n){
+        queue& own = *(this->m_queues[self]);
+        std::lock_guard<std::mutex> lock{own.lock};
+        if(!own.tasks.empty()){
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            this->m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for(unsigned i = 1; i <= n; ++i){
+        queue& victim = *(this->m_queues[(self + i) % n]);
+        std::lock_guard<std::mutex> lock{victim.lock};
+        if(!victim.tasks.empty()){
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            this->m_queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Runs a task, keeping the first exception for wait() */
+inline void thread_pool::run_task(std::function<void()>& task){
+    try{
+        task();
+    }catch(...){
+        std::lock_guard<std::mutex> lock{this->m_sleep};
+        if(!this->m_error) this->m_error = std::current_exception();
+    }
+    task = nullptr;
+    if(this->m_pending.fetch_sub(1) == 1){
+        std::lock_guard<std::mutex> lock{this->m_sleep};
+        this->m_done.notify_all();
+    }
+}
+
+/** Loop of a worker: run tasks or sleep until new ones arrive */
+inline void thread_pool::work(unsigned self){
+    current_pool() = this;
+    current_index() = self;
+    std::function<void()> task;
+    while(true){
+        if(this->pop_task(task, self)){
+            this->run_task(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{this->m_sleep};
+        this->m_wake.wait(lock, [this]{ return this->m_stop || this->m_queued.load() > 0; });
+        if(this->m_stop && this->m_queued.load() == 0) return;
+    }
+}
+
+/** Pool of the calling thread, nullptr outside the workers */
+inline thread_pool*& thread_pool::current_pool(){
+    static thread_local thread_pool* pool = nullptr;
+    return pool;
+}
+
+/** Index of the calling worker in its pool */
+inline unsigned& thread_pool::current_index(){
+    static thread_local unsigned index = 0;
+    return index;
+}
+
+// Task groups
+
+inline task_group::task_group(thread_pool& pool) : m_pool(pool), m_pending(0), m_lock(), m_done(), m_error() {}
+
+/** Waits the tasks of the group, their errors are dropped */
+inline task_group::~task_group(){
+    try{
+        this->wait();
+    }catch(...){
+        // Errors not collected by a wait() are dropped
+    }
+}
+
+inline thread_pool& task_group::pool() const{
+    return this->m_pool;
+}
+
+/**
+ * Schedules a task of the group on the pool
+ * @param task the task to run, its exception is kept for wait()
+ */
+inline void task_group::submit(std::function<void()> task){
+    {
+        std::lock_guard<std::mutex> lock{this->m_lock};
+        ++(this->m_pending);
+    }
+    this->m_pool.submit([this, task]{
+        std::exception_ptr error = nullptr;
+        try{
+            task();
+        }catch(...){
+            error = std::current_exception();
+        }
+        this->finish(error);
+    });
+}
+
+/** Counts a task as done, the group can be destroyed as soon as the lock is released */
+inline void task_group::finish(std::exception_ptr error){
+    std::lock_guard<std::mutex> lock{this->m_lock};
+    if(error && !this->m_error) this->m_error = error;
+    if(--(this->m_pending) == 0) this->m_done.notify_all();
+}
+
+/**
+ * Waits until the tasks of the group are done, running tasks of the pool
+ * meanwhile(so it can be called from a task too).
+ * Rethrows the first exception thrown by a task of the group.
+ */
+inline void task_group::wait(){
+    unsigned self = thread_pool::current_pool() == &(this->m_pool) ? thread_pool::current_index() : this->m_pool.size();
+    std::function<void()> task;
+    while(true){
+        {
+            std::lock_guard<std::mutex> lock{this->m_lock};
+            if(this->m_pending == 0) break;
+        }
+        if(this->m_pool.pop_task(task, self)){
+            this->m_pool.run_task(task);
+            continue;
+        }
+        // The tasks left are running elsewhere: sleep, checking the deques now and then
+        std::unique_lock<std::mutex> lock{this->m_lock};
+        this->m_done.wait_for(lock, std::chrono::milliseconds{1}, [this]{ return this->m_pending == 0; });
+    }
+    std::exception_ptr error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock{this->m_lock};
+        std::swap(error, this->m_error);
+    }
+    if(error) std::rethrow_exception(error);
+}
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef TRIE_EVENTS_HPP
+#define TRIE_EVENTS_HPP
+
+/*
+ * Event (SAX-style) parser for .tr input: the grammar of operator>> is run
+ * as a state machine and every node is reported to a handler instead of
+ * being stored, so the memory doesn't depend on the size of the input(only
+ * the current step and the depth are kept).
+ *
+ * The handler provides:
+ *     void on_enter(T const& label);             // a node with children begins
+ *     void on_leaf(T const* label, double w);    // a leaf(label nullptr for a root leaf)
+ *     void on_exit();                            // the last entered node ends
+ * Events come in file order; since nothing is stored, duplicated labels
+ * aren't detected(operator>> rejects them).
+ *
+ * Every step reads the stream with the same extractions as operator>>
+ * (labels with operator>> of T, weights as double, the keywords), so the
+ * accepted input is the same: a label can hold any character its
+ * operator>> takes, and "a1.0 children = {}" is a leaf 'a' for trie<char>.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+/* state machine of the grammar, one step per node or separator */
+template <typename T, typename Handler>
+struct trie_event_parser {
+    explicit trie_event_parser(Handler& handler);
+
+    /**
+     * Reads one step from is and reports its event
+     * @param last if is holds the whole rest of the input
+     * @return false if is ended inside the step(only when !last): nothing
+     * is reported and the step has to be read again with more input
+    */
+    bool step(std::istream& is, bool last);
+
+    /* the closing brace of the root(or the root leaf) has been read */
+    bool done() const;
+    /* nothing else than blanks follows the trie */
+    bool finished() const;
+    std::size_t depth() const;
+
+private:
+    enum state {
+        root,        // ROOT: LEAF or children = {NODE}
+        node,        // NODE: LABEL LEAF or LABEL children = {NODE}
+        after_node,  // , NODE or }
+        trailing,    // blanks up to the end
+        end
+    };
+
+    enum event { no_event, enter_event, leaf_event, exit_event };
+
+    /* what a step read, reported only when the step is complete */
+    struct result {
+        state next;
+        event e;
+        std::size_t depth;
+        T label;
+        double weight;
+    };
+
+    void read(std::istream& is, result& r) const;
+
+    Handler& m_handler;
+    state m_state;
+    std::size_t m_depth;  // open braces
+};
+
+/**
+ * Parses a .tr stream reporting the events to the handler.
+ * Errors are parser_exception as for operator>>.
+ */
+template <typename T, typename Handler>
+std::istream& parse_events(std::istream& is, Handler& handler);
+
+/* handler that builds a trie from the events, in place */
+template <typename T>
+struct trie_builder {
+    explicit trie_builder(trie<T>& t);
+
+    void on_enter(T const& label);
+    void on_leaf(T const* label, double w);
+    void on_exit();
+
+private:
+    std::vector<trie<T>*> m_open;  // nodes whose children are being read
+};
+
+/**
+ * Resumable parser for input arriving in chunks: feed() runs the event
+ * machine on every chunk, keeping the grammar state(open nodes) between
+ * calls and building the trie meanwhile, so loading overlaps the transfer.
+ * Chunks can split the input anywhere, even inside a token: the input of
+ * a step that reaches the end of the chunk is kept and read again with
+ * the next one. After an exception the parser can't be used anymore.
+ */
+template <typename T>
+struct incremental_parser {
+    incremental_parser();
+
+    incremental_parser(incremental_parser<T> const&) = delete;
+    incremental_parser<T>& operator=(incremental_parser<T> const&) = delete;
+
+    void feed(char const* data, std::size_t size);
+    trie<T> finish();
+
+    bool done() const;
+    trie<T> const& partial() const;
+
+private:
+    trie<T> m_trie;
+    trie_builder<T> m_builder;
+    trie_event_parser<T, trie_builder<T>> m_parser;
+    std::string m_pending;  // input of the step not complete yet
+};
+
+#endif
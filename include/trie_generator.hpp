@@ -0,0 +1,99 @@
+#ifndef TRIE_GENERATOR_HPP
+#define TRIE_GENERATOR_HPP
+
+/*
+ * Generator of synthetic .tr files of any size, for trie<char>, trie<int>,
+ * trie<double> and trie<std::string>.
+ *
+ * The text is written while the shape is drawn, so the size of the output
+ * doesn't depend on memory: only the open nodes(and the budgets of their
+ * children) are kept. Every node gets a number of leaves and splits it
+ * among its children:
+ *   - the fan-out follows a Zipf law over 1..max_fanout(exponent zipf_s,
+ *     0 is uniform), the last level(max_depth) takes all the leaves left;
+ *   - a single leaf ends at a depth uniform in [min_depth, max_depth],
+ *     so the depth distribution of the leaves is configurable;
+ *   - with chain_probability an inner node hangs below a chain of
+ *     chain_length single-child nodes(input for path_compress), the
+ *     chain doesn't count in the depth;
+ *   - with wide_probability an inner node has wide_fanout children.
+ * Sibling labels are distinct(trie<char> has 90 printable labels, the
+ * fan-out is cut there), weights are uniform in [min_weight, max_weight]
+ * with two decimals.
+ *
+ * The output depends only on the options: the random numbers come from
+ * std::mt19937_64, which is the same on every platform, and are not
+ * passed through the standard distributions(their results are
+ * implementation-defined).
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct generator_options {
+    std::uint64_t seed = 42;
+    std::size_t leaves = 1000;
+    std::size_t max_fanout = 8;
+    double zipf_s = 1.0;
+    std::size_t min_depth = 1;
+    std::size_t max_depth = 6;
+    double chain_probability = 0.0;
+    std::size_t chain_length = 16;
+    double wide_probability = 0.0;
+    std::size_t wide_fanout = 1000;
+    double min_weight = 0.0;
+    double max_weight = 1000.0;
+    bool indent = true;  // as operator<<, otherwise one node per line
+};
+
+template <typename T>
+struct trie_generator {
+    /* constructors */
+    explicit trie_generator(generator_options const& options);
+
+    /* writes the trie of the options, the same at every call */
+    std::ostream& write(std::ostream& os);
+
+private:
+    struct child {
+        std::string label;
+        std::size_t leaves;
+    };
+
+    /* open node whose children are being written */
+    struct frame {
+        std::vector<child> children;
+        std::size_t next;
+        std::size_t depth;  // of the node, without chains
+        std::size_t level;  // of the node, for the indentation
+        std::size_t chain;  // single-child nodes to close above it
+    };
+
+    void visit(std::ostream& os, std::string const* label, std::size_t leaves, std::size_t depth, std::size_t level, std::vector<frame>& stack);
+    void open(std::ostream& os, std::string const* label, std::size_t level);
+    void close(std::ostream& os, std::size_t level);
+    void leaf(std::ostream& os, std::string const* label, std::size_t level);
+    void tabs(std::ostream& os, std::size_t level);
+
+    std::vector<std::size_t> split(std::size_t leaves, std::size_t fanout);
+    std::vector<std::string> sibling_labels(std::size_t n);
+    std::size_t fanout();
+
+    std::uint64_t below(std::uint64_t n);
+    double unit();
+
+    generator_options m_options;
+    std::vector<double> m_zipf;  // m_zipf[k - 1]: P(fan-out <= k)
+    std::mt19937_64 m_gen;
+};
+
+/* parses a generated trie */
+template <typename T>
+trie<T> generate_trie(generator_options const& options);
+
+#endif
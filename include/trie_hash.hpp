@@ -0,0 +1,62 @@
+#ifndef TRIE_HASH_HPP
+#define TRIE_HASH_HPP
+
+/*
+ * Structural (Merkle) hashes of tries, consistent with trie<T>::operator==:
+ * a leaf hashes its weight, an inner node the labels(std::hash<T>) and
+ * the hashes of its children in order; the label of the node itself and
+ * the weight of an inner node are left out, as operator== does. Equal
+ * tries have equal hashes.
+ *
+ * hash_trie() computes the hash of a trie in O(n), trie_hasher plugs it in
+ * unordered containers. hash_index caches the hash of every inner node in
+ * a side_index, which keeps them on its mutations: hash() is then O(1).
+ * probably_equal() of two indexed tries compares the root hashes only,
+ * O(1), and is wrong only on a collision of 64-bit hashes. equal() is
+ * exact: it answers false in O(1) when the roots differ, otherwise it
+ * descends only in the pairs of sub-tries whose hashes match, so proving
+ * two tries equal still visits every node(O(n)).
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "side_index.hpp"
+
+/* hash of a trie, O(n) */
+template <typename T>
+std::uint64_t hash_trie(trie<T> const& t);
+
+/* hash functor for unordered containers of tries */
+template <typename T>
+struct trie_hasher {
+    std::size_t operator()(trie<T> const& t) const;
+};
+
+template <typename T>
+struct hash_index : side_index<T, std::uint64_t, hash_index<T>> {
+    /* constructors */
+    explicit hash_index(trie<T>& t);
+
+    /* hash of the indexed trie or of one of its sub-tries, O(1) */
+    std::uint64_t hash() const;
+    std::uint64_t hash(trie<T> const& sub) const;
+
+private:
+    friend struct side_index<T, std::uint64_t, hash_index<T>>;
+
+    std::uint64_t build(trie<T> const& t);
+    void update_entry(trie<T> const& t);
+};
+
+/* same root hashes, O(1): equal up to a hash collision */
+template <typename T>
+bool probably_equal(hash_index<T> const& a, hash_index<T> const& b);
+
+/* operator== of the indexed tries, pruned by the hashes(O(n) when they are equal) */
+template <typename T>
+bool equal(hash_index<T> const& a, hash_index<T> const& b);
+
+#endif
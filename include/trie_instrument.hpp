@@ -0,0 +1,96 @@
+#ifndef TRIE_INSTRUMENT_HPP
+#define TRIE_INSTRUMENT_HPP
+
+/*
+ * Opt-in instrumentation of the hot paths of trie<T> and bag<T>.
+ *
+ * bag.hpp and trie.cpp call two hooks that expand to nothing by default,
+ * so normal builds pay nothing:
+ *     TRIE_COUNT(counter)  bumps nodes_visited(children scanned by
+ *                          operator[], leaf_iterator::operator++, end()),
+ *                          label_comparisons, subtree_comparisons(calls of
+ *                          trie::operator== and !=) or allocations(new T
+ *                          labels and bag nodes)
+ *     TRIE_OP_SCOPE(op)    times an operation and charges it the counters
+ *                          bumped meanwhile
+ * Including src/trie_instrument.cpp before src/trie.cpp defines them.
+ *
+ * Operations are lookup(operator[]), leaf_next(leaf iterators ++), end,
+ * max, parse(operator>>), merge(operator+, +=) and compress(path_compress).
+ * Stats are inclusive: max() also counts the leaf_next and end calls it
+ * makes; a recursive operation is recorded by its outermost call only.
+ * The latency histogram has power-of-two buckets of nanoseconds.
+ *
+ * Stats are per thread(thread_local), read them from the thread that ran
+ * the operations.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if defined(TRIE_COUNT) || defined(TRIE_OP_SCOPE)
+#error "trie_instrument must be included before bag.hpp and trie.cpp"
+#endif
+
+enum class trie_op { lookup, leaf_next, end, max, parse, merge, compress, count };
+
+struct trie_counters {
+    std::uint64_t nodes_visited = 0;
+    std::uint64_t label_comparisons = 0;
+    std::uint64_t subtree_comparisons = 0;
+    std::uint64_t allocations = 0;
+};
+
+/* stats of one operation */
+struct trie_op_stats {
+    static constexpr std::size_t buckets = 48;  // bucket i: latency in [2^i, 2^(i+1)) ns
+
+    std::uint64_t calls = 0;
+    std::uint64_t total_ns = 0;
+    trie_counters counters;
+    std::array<std::uint64_t, buckets> histogram{};
+
+    void record(std::uint64_t ns, trie_counters const& delta);
+    /* upper bound of the bucket of the q-quantile(q in [0, 1]) */
+    std::uint64_t percentile_ns(double q) const;
+};
+
+/* instruments of a thread */
+struct trie_instrumentation {
+    trie_counters counters;  // running totals, bumped by TRIE_COUNT
+    std::array<trie_op_stats, static_cast<std::size_t>(trie_op::count)> ops;
+    std::array<bool, static_cast<std::size_t>(trie_op::count)> running{};
+
+    trie_op_stats const& operator[](trie_op op) const;
+    void reset();
+};
+
+trie_instrumentation& trie_instruments();
+char const* trie_op_name(trie_op op);
+
+/* one "name value" line per counter and percentile */
+std::ostream& operator<<(std::ostream& os, trie_instrumentation const& instruments);
+
+/* times an operation from its construction to its destruction */
+struct trie_op_timer {
+    explicit trie_op_timer(trie_op op);
+    ~trie_op_timer();
+
+    trie_op_timer(trie_op_timer const&) = delete;
+    trie_op_timer& operator=(trie_op_timer const&) = delete;
+
+private:
+    trie_op m_op;
+    bool m_outer;  // false in a recursive call of the same operation
+    trie_counters m_start;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+#define TRIE_INSTRUMENTATION 1
+#define TRIE_COUNT(counter) (++(trie_instruments().counters.counter))
+#define TRIE_OP_SCOPE(op) trie_op_timer trie_op_timer_scope{trie_op::op}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef TRIE_MEMORY_HPP
+#define TRIE_MEMORY_HPP
+
+/*
+ * Memory accounting of trie<T>.
+ *
+ * memory_usage() walks a trie and splits its footprint by category:
+ *     nodes   the trie<T> objects(the root included, wherever it lives)
+ *     links   what bag<T>::Node adds around each child: next pointer, padding
+ *     labels  the heap labels(new T) and what they own(std::string buffers)
+ *     slack   allocator rounding and chunk headers, estimated for a
+ *             malloc with one size_t of header and 2 * size_t granularity
+ *
+ * Defining TRIE_TRACK_ALLOCATIONS before including src/trie_memory.cpp
+ * replaces the global operator new/delete(non aligned ones) with counting
+ * versions, so allocation_scope reports what parse, copy, merge or
+ * path_compress allocate. Every allocation, not only the trie ones, is
+ * counted. Define it in one translation unit only; without it the
+ * allocation counters stay at 0.
+ *
+ * Both stats print as "name value" lines for monitoring scrapers.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <ostream>
+
+struct memory_stats {
+    std::size_t nodes = 0;
+    std::size_t labels = 0;
+    std::size_t node_bytes = 0;
+    std::size_t link_bytes = 0;
+    std::size_t label_bytes = 0;
+    std::size_t slack_bytes = 0;
+
+    std::size_t total_bytes() const;
+    double bytes_per_node() const;
+};
+
+/* footprint of a trie(or sub-trie) */
+template <typename T>
+memory_stats memory_usage(trie<T> const& t);
+
+std::ostream& operator<<(std::ostream& os, memory_stats const& s);
+
+/* allocation counters, global or of a scope */
+struct allocation_stats {
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+    std::size_t allocated_bytes = 0;
+    std::size_t freed_bytes = 0;
+    std::size_t peak_bytes = 0;  // max live bytes(for a scope: above the ones at its start)
+
+    long long live_bytes() const;
+};
+
+std::ostream& operator<<(std::ostream& os, allocation_stats const& s);
+
+/* if the counting operator new is compiled in */
+bool allocations_tracked();
+
+/* counters since the start of the program */
+allocation_stats current_allocations();
+
+/* counters since its construction; the peak of nested scopes is shared */
+struct allocation_scope {
+    allocation_scope();
+
+    allocation_stats stats() const;
+
+private:
+    allocation_stats m_start;
+};
+
+#endif
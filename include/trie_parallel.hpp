@@ -0,0 +1,104 @@
+#ifndef TRIE_PARALLEL_HPP
+#define TRIE_PARALLEL_HPP
+
+/*
+ * Parallel algorithms on trie<T>.
+ * Include it after src/trie.cpp.
+ */
+
+#include <istream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+/* parallel loading of .tr files */
+
+/**
+ * Parses the content of a .tr file using all the workers of the pool.
+ * A brace-matching pre-scan splits the children list of the root into
+ * chunks; big children are split as well, down to split_depth levels below
+ * the root. Each chunk is parsed by the sequential grammar into its own
+ * subtree and the subtrees are stitched in label order.
+ * Labels must not contain braces or commas.
+ * Errors are parser_exception as for operator>>: a malformed structure is
+ * left to the sequential parser, errors inside chunks are reported in file
+ * order, duplicated labels across chunks while stitching.
+ */
+template <typename T>
+void parallel_parse(std::string const& text, trie<T>& t, thread_pool& pool, unsigned split_depth = 1);
+
+/** Reads the whole stream and parses it with parallel_parse */
+template <typename T>
+std::istream& parallel_load(std::istream& is, trie<T>& t, unsigned threads = 0, unsigned split_depth = 1);
+
+/* parallel traversal and reductions over the leaves */
+
+/**
+ * Calls f on every leaf(trie<T>& or trie<T> const&), in no particular order
+ * and concurrently. A task visiting a subtree hands its outermost pending
+ * siblings to the pool every grain visited nodes, so big subtrees get split
+ * while small ones are walked by a single task.
+ */
+template <typename T, typename F>
+void parallel_for_each_leaf(trie<T>& t, F f, thread_pool& pool, std::size_t grain = 4096);
+
+template <typename T, typename F>
+void parallel_for_each_leaf(trie<T> const& t, F f, thread_pool& pool, std::size_t grain = 4096);
+
+/**
+ * Reduces the leaves: map(trie<T> const&) -> R, combined with reduce(R, R) -> R.
+ * reduce must be associative and commutative (the order of the partial
+ * results isn't fixed, floating point sums may differ in the last bits).
+ */
+template <typename T, typename R, typename Map, typename Reduce>
+R parallel_reduce(trie<T> const& t, R init, Map map, Reduce reduce, thread_pool& pool, std::size_t grain = 4096);
+
+/** Number of leaves */
+template <typename T>
+std::size_t parallel_leaf_count(trie<T> const& t, thread_pool& pool);
+
+/** Sum of the weights of the leaves */
+template <typename T>
+double parallel_weight_sum(trie<T> const& t, thread_pool& pool);
+
+/** Leaf with max weight, the same one returned by max() (first one in lexicographic order on ties) */
+template <typename T>
+trie<T>& parallel_max(trie<T>& t, thread_pool& pool);
+
+template <typename T>
+trie<T> const& parallel_max(trie<T> const& t, thread_pool& pool);
+
+/* union of many tries */
+
+/**
+ * dst += src moving the subtrees of src instead of copying them.
+ * The result is the same of operator+=, src is left with the nodes that
+ * were merged in dst and has to be discarded.
+ * With a pool, the pairs of children with the same label in the first
+ * split_depth levels are merged by concurrent tasks; it returns when they
+ * are done(other tasks of the pool aren't waited).
+ */
+template <typename T>
+trie<T>& merge_into(trie<T>& dst, trie<T>& src);
+
+template <typename T>
+trie<T>& merge_into(trie<T>& dst, trie<T>& src, thread_pool& pool, unsigned split_depth = 1);
+
+/**
+ * Union of count tries, same result of shards[0] + shards[1] + ... (weights
+ * included, summed in the same order); the shards are consumed.
+ * operator+ isn't associative when a sequence of a shard is a prefix of one
+ * of another shard, so instead of merging pairs of shards the reduction is
+ * split by label: the children of the shards with the same label, in the
+ * first split_depth levels, are folded by concurrent tasks and the subtrees
+ * are relinked, never copied.
+ */
+template <typename T>
+trie<T> merge_all(trie<T>* shards, std::size_t count, thread_pool& pool, unsigned split_depth = 2);
+
+template <typename T>
+trie<T> merge_all(std::vector<trie<T>>& shards, thread_pool& pool, unsigned split_depth = 2);
+
+#endif
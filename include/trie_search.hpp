@@ -0,0 +1,141 @@
+#ifndef TRIE_SEARCH_HPP
+#define TRIE_SEARCH_HPP
+
+/*
+ * Approximate, pattern and range queries on trie<T>.
+ * Include it after src/trie.cpp.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/* leaf found by a query */
+template <typename T>
+struct trie_match {
+    trie<T> const* leaf;
+    std::vector<T> sequence;
+    double weight;
+    std::size_t distance;
+};
+
+/**
+ * Leaves whose sequence is within max_edits edits(insertions, deletions,
+ * substitutions of one label) from s.
+ * The trie is walked depth-first keeping one row of the Levenshtein matrix
+ * per level, a branch is pruned as soon as the minimum of its row is over
+ * max_edits.
+ * With top_k = 0 all the matches are returned in lexicographic order,
+ * otherwise the top_k ones with max weight(ties: smaller distance, then
+ * lexicographic order).
+ */
+template <typename T>
+std::vector<trie_match<T>> fuzzy_search(trie<T> const& t, std::vector<T> const& s, std::size_t max_edits, std::size_t top_k = 0);
+
+/* pattern queries */
+
+/* element of a pattern: a label, any one label or any run(also empty) of labels */
+template <typename T>
+struct pattern_token {
+    enum kind_type { label, any_one, any_run };
+
+    static pattern_token<T> exact(T const& value);
+    static pattern_token<T> one();
+    static pattern_token<T> run();
+
+    kind_type kind;
+    T value;  // meaningful for label only
+};
+
+/**
+ * Iterator on the leaves matching a pattern, in lexicographic order.
+ * The trie is walked lazily: every increment resumes the depth-first
+ * descent, which keeps for each node the set of pattern positions reached
+ * by its sequence and drops a branch when the set becomes empty.
+ */
+template <typename T>
+struct pattern_iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = const T;
+    using pointer = T const*;
+    using reference = T const&;
+
+    pattern_iterator();
+    pattern_iterator(trie<T> const& t, std::vector<pattern_token<T>> const& pattern);
+
+    reference operator*() const;
+    pointer operator->() const;
+    pattern_iterator& operator++();
+    pattern_iterator operator++(int);
+    bool operator==(pattern_iterator const&) const;
+    bool operator!=(pattern_iterator const&) const;
+
+    trie<T> const& get_leaf() const;
+    std::vector<T> sequence() const;
+
+private:
+    struct frame {
+        typename bag<trie<T>>::const_iterator it;
+        typename bag<trie<T>>::const_iterator end;
+        std::vector<std::size_t> states;  // pattern positions reached by the node
+    };
+
+    void closure(std::vector<std::size_t>& states) const;
+    std::vector<std::size_t> step(std::vector<std::size_t> const& states, T const& label) const;
+    bool accepts(std::vector<std::size_t> const& states) const;
+    void advance();
+
+    std::vector<pattern_token<T>> m_pattern;
+    std::vector<frame> m_stack;
+    std::vector<T> m_path;   // labels of the nodes of the stack, root excluded
+    trie<T> const* m_leaf;   // nullptr at the end
+};
+
+/* matches of a pattern, usable in a range-based for */
+template <typename T>
+struct pattern_range {
+    pattern_iterator<T> begin() const;
+    pattern_iterator<T> end() const;
+
+    trie<T> const* t;
+    std::vector<pattern_token<T>> pattern;
+};
+
+/** Leaves of t whose sequence matches the pattern */
+template <typename T>
+pattern_range<T> pattern_search(trie<T> const& t, std::vector<pattern_token<T>> const& pattern);
+
+/**
+ * Pattern for trie<char> from a string: '?' is any one label, '*' any run,
+ * '\\' makes the next character a label
+ */
+inline std::vector<pattern_token<char>> make_pattern(std::string const& text);
+
+/* range queries, leaves are in lexicographic order of their sequences */
+
+/**
+ * First leaf whose sequence(from t) is not less than s, t.end() if none.
+ * The leaf is reached descending the path of s once(O(depth * fan-out),
+ * the children are a sorted list) instead of scanning from begin().
+ */
+template <typename T>
+typename trie<T>::leaf_iterator lower_bound(trie<T>& t, std::vector<T> const& s);
+
+template <typename T>
+typename trie<T>::const_leaf_iterator lower_bound(trie<T> const& t, std::vector<T> const& s);
+
+/** First leaf whose sequence is greater than s(the extensions of s are greater), t.end() if none */
+template <typename T>
+typename trie<T>::leaf_iterator upper_bound(trie<T>& t, std::vector<T> const& s);
+
+template <typename T>
+typename trie<T>::const_leaf_iterator upper_bound(trie<T> const& t, std::vector<T> const& s);
+
+/** Leaves with lo <= sequence < hi, as [lower_bound(lo), lower_bound(hi)) */
+template <typename T>
+std::pair<typename trie<T>::leaf_iterator, typename trie<T>::leaf_iterator> range(trie<T>& t, std::vector<T> const& lo, std::vector<T> const& hi);
+
+template <typename T>
+std::pair<typename trie<T>::const_leaf_iterator, typename trie<T>::const_leaf_iterator> range(trie<T> const& t, std::vector<T> const& lo, std::vector<T> const& hi);
+
+#endif
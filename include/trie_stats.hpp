@@ -0,0 +1,52 @@
+#ifndef TRIE_STATS_HPP
+#define TRIE_STATS_HPP
+
+/*
+ * Shape of a trie<T>, collected in one traversal:
+ *     depth        leaves and nodes at each depth(the root is at 0)
+ *     fan-out      inner nodes by number of children
+ *     chains       maximal runs of non-root nodes with a single child,
+ *                  by length: path_compress merges every such node into
+ *                  its child
+ *     label sizes  labels by length of their text(operator<<)
+ * recommendations() turns the numbers into advice on path_compress and
+ * on the node layout.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct trie_stats {
+    std::size_t nodes = 0;
+    std::size_t leaves = 0;
+    std::size_t max_depth = 0;
+    std::vector<std::size_t> leaves_by_depth;
+    std::vector<std::size_t> nodes_by_depth;
+    std::map<std::size_t, std::size_t> fanout;       // children -> inner nodes
+    std::map<std::size_t, std::size_t> chains;       // length -> chains
+    std::map<std::size_t, std::size_t> label_sizes;  // characters -> labels
+    std::size_t node_bytes = 0;                      // memory_usage(t).bytes_per_node(), rounded
+
+    std::size_t inner() const;
+    double mean_leaf_depth() const;
+    double mean_fanout() const;
+    /* nodes removed by path_compress */
+    std::size_t compressible() const;
+};
+
+/* shape of a trie(or sub-trie) */
+template <typename T>
+trie_stats collect_stats(trie<T> const& t);
+
+/* advice drawn from the stats, one line each */
+std::vector<std::string> recommendations(trie_stats const& s);
+
+/* report with a "value count" line per histogram bucket */
+std::ostream& operator<<(std::ostream& os, trie_stats const& s);
+
+#endif
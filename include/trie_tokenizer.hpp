@@ -0,0 +1,74 @@
+#ifndef TRIE_TOKENIZER_HPP
+#define TRIE_TOKENIZER_HPP
+
+/*
+ * Greedy longest-match segmentation of an input(std::string for
+ * trie<char>, std::vector<std::string> for trie<std::string>, any sequence
+ * of T) into the sequences of a dictionary trie.
+ *
+ * The dictionary entries are the paths from the root to the leaves. At
+ * every position the dictionary is walked once along the input until a
+ * leaf or a missing label: a leaf gives a token with its weight. Where no
+ * entry starts, the labels are collected in one unknown token up to the
+ * next position where an entry starts.
+ *
+ * The tokenizer walks a flat_trie copy of the dictionary, so every step
+ * is a binary search in a small contiguous range instead of a walk of the
+ * linked children; the trie can change or be destroyed afterwards.
+ * tokenize_batch() segments many documents in a task_group of a
+ * thread_pool, the tokenizer is only read and is shared by the tasks.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "flat_trie.hpp"
+#include "thread_pool.hpp"
+
+/* token of an input */
+struct trie_token {
+    std::size_t begin;   // offset of its first label
+    std::size_t length;  // number of labels
+    double weight;       // weight of the leaf, 0 for an unknown token
+    bool known;          // if it is a dictionary entry
+};
+
+template <typename T>
+struct trie_tokenizer {
+    using index_type = typename flat_trie<T>::index_type;
+
+    /* constructors */
+    trie_tokenizer();
+    explicit trie_tokenizer(trie<T> const& dictionary);
+
+    /**
+     * Segments [first, last) and appends its tokens to out
+     * @return The number of tokens appended
+    */
+    template <typename Iterator>
+    std::size_t tokenize(Iterator first, Iterator last, std::vector<trie_token>& out) const;
+    template <typename Sequence>
+    std::size_t tokenize(Sequence const& input, std::vector<trie_token>& out) const;
+
+    /**
+     * Segments every document, the tokens of documents[i] go in the i-th
+     * vector. Consecutive documents are grouped in tasks of about grain labels.
+    */
+    template <typename Sequence>
+    std::vector<std::vector<trie_token>> tokenize_batch(std::vector<Sequence> const& documents, thread_pool& pool, std::size_t grain = 1 << 16) const;
+
+    /* size of the copy */
+    std::size_t nodes() const;
+    std::size_t bytes() const;
+
+private:
+    template <typename Iterator>
+    std::size_t longest_entry(Iterator first, Iterator last, double& weight) const;
+
+    flat_trie<T> m_trie;
+};
+
+#endif
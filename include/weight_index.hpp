@@ -0,0 +1,55 @@
+#ifndef WEIGHT_INDEX_HPP
+#define WEIGHT_INDEX_HPP
+
+/*
+ * Side index of the weight sums of the sub-tries of a trie<T>, used to
+ * sample leaves with probability proportional to their weight.
+ *
+ * The index keeps, for each internal node, the pointers to its children
+ * and the prefix sums of their weights: a draw descends from a sub-trie
+ * with one binary search per level(O(depth * log fan-out)). Weights must
+ * not be negative. The table and its updates are the ones of side_index.
+ *
+ * Include it after src/trie.cpp.
+ */
+
+#include <vector>
+
+#include "side_index.hpp"
+
+/* entry of an internal node */
+template <typename T>
+struct weight_index_entry {
+    std::vector<trie<T> const*> children;
+    std::vector<double> prefix;  // prefix[i]: sum of the children 0..i
+};
+
+template <typename T>
+struct weight_index : side_index<T, weight_index_entry<T>, weight_index<T>> {
+    /* constructors */
+    explicit weight_index(trie<T>& t);
+
+    /* sum of the weights of the leaves of a sub-trie of the indexed trie */
+    double sum(trie<T> const& sub) const;
+
+    /* draws leaves with probability proportional to their weight(with replacement) */
+    template <typename Rng>
+    trie<T> const& sample(Rng& rng) const;
+    template <typename Rng>
+    trie<T> const& sample(trie<T> const& sub, Rng& rng) const;
+    template <typename Rng>
+    std::vector<trie<T> const*> sample_n(Rng& rng, std::size_t n) const;
+    template <typename Rng>
+    std::vector<trie<T> const*> sample_n(trie<T> const& sub, Rng& rng, std::size_t n) const;
+
+    /* set_weight of side_index, rejecting negative weights */
+    void set_weight(trie<T>& leaf, double w);
+
+private:
+    friend struct side_index<T, weight_index_entry<T>, weight_index<T>>;
+
+    double build(trie<T> const& t);
+    void update_entry(trie<T> const& t);
+};
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef AGGREGATE_INDEX_CPP
+#define AGGREGATE_INDEX_CPP
+
+#include <algorithm>
+#include <limits>
+
+#include "side_index.cpp"
+#include "aggregate_index.hpp"
+
+// Policies
+
+inline leaf_count_policy::value_type leaf_count_policy::identity(){ return 0; }
+inline leaf_count_policy::value_type leaf_count_policy::leaf(double){ return 1; }
+inline leaf_count_policy::value_type leaf_count_policy::combine(value_type a, value_type b){ return a + b; }
+
+inline weight_sum_policy::value_type weight_sum_policy::identity(){ return 0.0; }
+inline weight_sum_policy::value_type weight_sum_policy::leaf(double w){ return w; }
+inline weight_sum_policy::value_type weight_sum_policy::combine(value_type a, value_type b){ return a + b; }
+
+inline weight_min_policy::value_type weight_min_policy::identity(){ return std::numeric_limits<double>::infinity(); }
+inline weight_min_policy::value_type weight_min_policy::leaf(double w){ return w; }
+inline weight_min_policy::value_type weight_min_policy::combine(value_type a, value_type b){ return std::min(a, b); }
+
+inline weight_max_policy::value_type weight_max_policy::identity(){ return -std::numeric_limits<double>::infinity(); }
+inline weight_max_policy::value_type weight_max_policy::leaf(double w){ return w; }
+inline weight_max_policy::value_type weight_max_policy::combine(value_type a, value_type b){ return std::max(a, b); }
+
+inline subtree_aggregates_policy::value_type subtree_aggregates_policy::identity(){
+    return {0, 0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+}
+
+inline subtree_aggregates_policy::value_type subtree_aggregates_policy::leaf(double w){
+    return {1, w, w, w};
+}
+
+inline subtree_aggregates_policy::value_type subtree_aggregates_policy::combine(value_type const& a, value_type const& b){
+    return {a.count + b.count, a.sum + b.sum, std::min(a.min, b.min), std::max(a.max, b.max)};
+}
+
+// Constructors
+
+/** Computes the aggregates of every sub-trie of t */
+template <typename T, typename Policy>
+aggregate_index<T, Policy>::aggregate_index(trie<T>& t) : side_index<T, value_type, aggregate_index<T, Policy>>(t) {
+    this->build(t);
+}
+
+/**
+ * Computes the aggregates of a sub-trie(post order)
+ * @return The aggregate of t
+*/
+template <typename T, typename Policy>
+typename aggregate_index<T, Policy>::value_type aggregate_index<T, Policy>::build(trie<T> const& t){
+    if(t.get_children().empty()) return Policy::leaf(t.get_weight());
+    value_type v = Policy::identity();
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        v = Policy::combine(v, this->build(*it));
+    }
+    this->m_entries[&t] = v;
+    return v;
+}
+
+/** Recomputes the aggregate of an internal node from its children */
+template <typename T, typename Policy>
+void aggregate_index<T, Policy>::update_entry(trie<T> const& t){
+    value_type v = Policy::identity();
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        v = Policy::combine(v, this->get(*it));
+    }
+    this->m_entries[&t] = v;
+}
+
+// Queries
+
+/** Returns the aggregate of a sub-trie of the indexed trie */
+template <typename T, typename Policy>
+typename aggregate_index<T, Policy>::value_type aggregate_index<T, Policy>::get(trie<T> const& sub) const{
+    if(sub.get_children().empty()) return Policy::leaf(sub.get_weight());
+    value_type const* e = this->find(sub);
+    if(!e) throw parser_exception{"The sub-trie is not indexed"};
+    return *e;
+}
+
+/**
+ * Returns the aggregate of the leaves whose sequence starts with prefix(O(depth * fan-out))
+ * @param prefix the prefix, identity() if no sequence starts with it
+*/
+template <typename T, typename Policy>
+typename aggregate_index<T, Policy>::value_type aggregate_index<T, Policy>::get(std::vector<T> const& prefix) const{
+    trie<T> const* reached = this->m_t;
+    for(auto const& l : prefix){
+        trie<T> const* child = nullptr;
+        for(auto it = reached->get_children().begin(); !child && it != reached->get_children().end(); ++it){
+            if(*(it->get_label()) == l) child = &(*it);
+        }
+        if(!child) return Policy::identity();
+        reached = child;
+    }
+    return this->get(*reached);
+}
+
+#endif
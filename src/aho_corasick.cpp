@@ -0,0 +1,162 @@
+#ifndef AHO_CORASICK_CPP
+#define AHO_CORASICK_CPP
+
+#include <iterator>
+#include <utility>
+
+#include "flat_trie.cpp"
+#include "aho_corasick.hpp"
+
+// Constructors
+
+/** Empty dictionary: the root alone, nothing matches */
+template <typename T>
+aho_corasick<T>::aho_corasick() : m_trie(), m_states{state{0, no_state, 0, false}}, m_patterns(0) {}
+
+/**
+ * Builds the automaton in one breadth-first visit of the flat copy: the
+ * links of a node are computed from the ones of its parent, and its
+ * failure chain only holds shallower nodes, numbered before the parent.
+ * @param dictionary the trie of the sequences to find
+*/
+template <typename T>
+aho_corasick<T>::aho_corasick(trie<T> const& dictionary) : m_trie(dictionary), m_states(m_trie.nodes()), m_patterns(0) {
+    this->m_states[0] = state{0, no_state, 0, false};
+    for(index_type s = 0; s < this->m_trie.nodes(); ++s){
+        typename flat_trie<T>::node const& nd = this->m_trie.get_node(s);
+        for(index_type e = nd.first; e < nd.first + nd.count; ++e){
+            typename flat_trie<T>::edge const& ed = this->m_trie.get_edge(e);
+
+            // Longest proper suffix of the child that is a path: extend the
+            // suffixes of s, from the longest
+            index_type fail = 0;
+            if(s != 0){
+                index_type f = this->m_states[s].fail;
+                while(true){
+                    index_type c = this->m_trie.child(f, ed.label);
+                    if(c != no_state){
+                        fail = c;
+                        break;
+                    }
+                    if(f == 0) break;
+                    f = this->m_states[f].fail;
+                }
+            }
+            state const& f = this->m_states[fail];
+            bool leaf = this->m_trie.is_leaf(ed.target);
+            this->m_states[ed.target] = state{fail, f.leaf ? fail : f.output, this->m_states[s].depth + 1, leaf};
+            if(leaf) ++(this->m_patterns);
+        }
+    }
+}
+
+template <typename T>
+typename aho_corasick<T>::scanner aho_corasick<T>::stream() const{
+    return scanner{this};
+}
+
+// Transitions
+
+/** Next state reading a label: the edge of s, else of its failure chain */
+template <typename T>
+typename aho_corasick<T>::index_type aho_corasick<T>::step(index_type s, T const& label) const{
+    while(true){
+        index_type c = this->m_trie.child(s, label);
+        if(c != no_state) return c;
+        if(s == 0) return 0;
+        s = this->m_states[s].fail;
+    }
+}
+
+/**
+ * Reports the matches ending in a state: the state itself if it is a leaf,
+ * then its output chain
+ * @return The number of matches
+*/
+template <typename T>
+template <typename Callback>
+std::size_t aho_corasick<T>::report(index_type s, std::size_t end, Callback& f) const{
+    std::size_t n = 0;
+    state const* st = &(this->m_states[s]);
+    if(st->leaf){
+        f(text_match{end, st->depth, this->m_trie.get_weight(s)});
+        ++n;
+    }
+    for(index_type o = st->output; o != no_state; o = this->m_states[o].output){
+        st = &(this->m_states[o]);
+        f(text_match{end, st->depth, this->m_trie.get_weight(o)});
+        ++n;
+    }
+    return n;
+}
+
+// Scan
+
+template <typename T>
+template <typename Iterator, typename Callback>
+std::size_t aho_corasick<T>::scan(Iterator first, Iterator last, Callback f) const{
+    scanner sc{this};
+    return sc.feed(first, last, f);
+}
+
+template <typename T>
+template <typename Sequence, typename Callback>
+std::size_t aho_corasick<T>::scan(Sequence const& text, Callback f) const{
+    return this->scan(std::begin(text), std::end(text), f);
+}
+
+template <typename T>
+template <typename Sequence>
+std::vector<text_match> aho_corasick<T>::find_all(Sequence const& text) const{
+    std::vector<text_match> result;
+    this->scan(text, [&result](text_match const& m){ result.push_back(m); });
+    return result;
+}
+
+template <typename T>
+std::size_t aho_corasick<T>::states() const{
+    return this->m_states.size();
+}
+
+/** Number of dictionary sequences(leaves of the trie) */
+template <typename T>
+std::size_t aho_corasick<T>::patterns() const{
+    return this->m_patterns;
+}
+
+/** Bytes of the flat trie and of the links */
+template <typename T>
+std::size_t aho_corasick<T>::bytes() const{
+    return this->m_trie.bytes() + this->m_states.size() * sizeof(state);
+}
+
+// Scanner
+
+template <typename T>
+aho_corasick<T>::scanner::scanner(aho_corasick<T> const* a) : m_a(a), m_state(0), m_offset(0) {}
+
+template <typename T>
+template <typename Iterator, typename Callback>
+std::size_t aho_corasick<T>::scanner::feed(Iterator first, Iterator last, Callback f){
+    std::size_t n = 0;
+    for(; first != last; ++first){
+        this->m_state = this->m_a->step(this->m_state, *first);
+        ++(this->m_offset);
+        state const& st = this->m_a->m_states[this->m_state];
+        if(st.leaf || st.output != no_state) n += this->m_a->report(this->m_state, this->m_offset, f);
+    }
+    return n;
+}
+
+template <typename T>
+std::size_t aho_corasick<T>::scanner::offset() const{
+    return this->m_offset;
+}
+
+template <typename T>
+void aho_corasick<T>::scanner::reset(){
+    this->m_state = 0;
+    this->m_offset = 0;
+}
+
+#endif
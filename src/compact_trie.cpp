@@ -0,0 +1,504 @@
+#ifndef COMPACT_TRIE_CPP
+#define COMPACT_TRIE_CPP
+
+#include "compact_trie.hpp"
+
+// Node reference
+
+/**
+ * Creates a reference to a node of a compact trie
+ * @param t the compact trie that owns the node
+ * @param n index of the node
+*/
+template <typename T>
+compact_trie<T>::node_ref::node_ref(compact_trie<T> const* t, index_type n) : m_t(t), m_n(n) {}
+
+/** Returns the weight */
+template <typename T>
+double compact_trie<T>::node_ref::get_weight() const{
+    return this->m_t->m_nodes[this->m_n].w;
+}
+
+/** Returns the label, nullptr for the root */
+template <typename T>
+T const* compact_trie<T>::node_ref::get_label() const{
+    if(this->m_n == 0) return nullptr;
+    return &(this->m_t->m_nodes[this->m_n].l);
+}
+
+/** Returns if the node is a leaf */
+template <typename T>
+bool compact_trie<T>::node_ref::is_leaf() const{
+    return this->m_t->m_nodes[this->m_n].k == leaf_kind;
+}
+
+/** Returns the number of children */
+template <typename T>
+std::size_t compact_trie<T>::node_ref::children_count() const{
+    return this->m_t->m_nodes[this->m_n].n;
+}
+
+/** Returns the children, sorted by label */
+template <typename T>
+std::vector<typename compact_trie<T>::node_ref> compact_trie<T>::node_ref::children() const{
+    std::vector<node_ref> children;
+    unsigned pos = 0;
+    for(index_type c = this->m_t->child_at(this->m_n, pos); c; c = this->m_t->child_at(this->m_n, ++pos)){
+        children.push_back({this->m_t, c});
+    }
+    return children;
+}
+
+/**
+ * Returns the sub-trie reached following the maximum number of labels of the sequence
+ * @param s The sequence with the labels
+ * @return The reference to the reached sub-trie
+*/
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::node_ref::operator[](std::vector<T> const& s) const{
+    index_type reached = this->m_n;
+    for(auto const& l : s){
+        index_type next = this->m_t->find_child(reached, key_of(l));
+        if(!next) break;
+        reached = next;
+    }
+    return {this->m_t, reached};
+}
+
+/**
+ * Returns the leaf with max weight of the sub-trie
+ * @return The leaf with max weight
+*/
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::node_ref::max() const{
+    auto it = this->begin();
+    index_type max = it.m_stack.back().node;
+    double max_w = this->m_t->m_nodes[max].w;
+    ++it;
+    while(it != this->end()){
+        index_type n = it.m_stack.back().node;
+        if(this->m_t->m_nodes[n].w > max_w){
+            max = n;
+            max_w = this->m_t->m_nodes[n].w;
+        }
+        ++it;
+    }
+    return {this->m_t, max};
+}
+
+/** Returns a leaf iterator to the first leaf of the sub-trie */
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator compact_trie<T>::node_ref::begin() const{
+    return {this->m_t, this->m_n, false};
+}
+
+/** Returns a leaf iterator to the leaf after the last one of the sub-trie */
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator compact_trie<T>::node_ref::end() const{
+    return {this->m_t, this->m_n, true};
+}
+
+template <typename T>
+bool compact_trie<T>::node_ref::operator==(node_ref const& rhs) const{
+    return this->m_t == rhs.m_t && this->m_n == rhs.m_n;
+}
+
+template <typename T>
+bool compact_trie<T>::node_ref::operator!=(node_ref const& rhs) const{
+    return !(*this == rhs);
+}
+
+// Leaf iterator
+
+/**
+ * Instantiates a leaf iterator on the sub-trie rooted in n
+ * @param t the compact trie
+ * @param n the root of the sub-trie
+ * @param end if the iterator has to point after the last leaf
+*/
+template <typename T>
+compact_trie<T>::const_leaf_iterator::const_leaf_iterator(compact_trie<T> const* t, index_type n, bool end)
+    : m_t(t), m_stack(){
+    if(!end){
+        this->m_stack.push_back({n, 0});
+        this->descend();
+    }
+}
+
+/** Follows the first child until a leaf is reached */
+template <typename T>
+void compact_trie<T>::const_leaf_iterator::descend(){
+    while(this->m_t->m_nodes[this->m_stack.back().node].k != leaf_kind){
+        unsigned pos = 0;
+        index_type c = this->m_t->child_at(this->m_stack.back().node, pos);
+        this->m_stack.back().pos = pos;
+        this->m_stack.push_back({c, 0});
+    }
+}
+
+/**
+ * Returns the label of the leaf the iterator points to
+ * @return The label pointed
+*/
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator::reference compact_trie<T>::const_leaf_iterator::operator*() const{
+    index_type n = this->m_stack.back().node;
+    return n ? this->m_t->m_nodes[n].l : throw parser_exception{"No label for the root"};
+}
+
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator::pointer compact_trie<T>::const_leaf_iterator::operator->() const{
+    return &(**this);
+}
+
+/**
+ * Points to the next leaf(pre-increment)
+ * @return An iterator that points to the next leaf || end if no other leaves
+*/
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator& compact_trie<T>::const_leaf_iterator::operator++(){
+    // Leave the leaf, then climb until a node has a next child
+    this->m_stack.pop_back();
+    while(!this->m_stack.empty()){
+        frame& top = this->m_stack.back();
+        unsigned pos = top.pos + 1;
+        index_type c = this->m_t->child_at(top.node, pos);
+        if(c){
+            top.pos = pos;
+            this->m_stack.push_back({c, 0});
+            this->descend();
+            return *this;
+        }
+        this->m_stack.pop_back();
+    }
+    return *this;
+}
+
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator compact_trie<T>::const_leaf_iterator::operator++(int){
+    const_leaf_iterator pre_increment{*this};
+    ++(*this);
+    return pre_increment;
+}
+
+template <typename T>
+bool compact_trie<T>::const_leaf_iterator::operator==(const_leaf_iterator const& rhs) const{
+    if(this->m_stack.empty() || rhs.m_stack.empty()){
+        return this->m_stack.empty() && rhs.m_stack.empty();
+    }
+    return this->m_t == rhs.m_t && this->m_stack.back().node == rhs.m_stack.back().node;
+}
+
+template <typename T>
+bool compact_trie<T>::const_leaf_iterator::operator!=(const_leaf_iterator const& rhs) const{
+    return !(*this == rhs);
+}
+
+/**
+ * Returns a reference to the actual leaf
+ * @return Leaf
+*/
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::const_leaf_iterator::get_leaf() const{
+    if(this->m_stack.empty()) throw parser_exception{"No leaf pointed"};
+    return {this->m_t, this->m_stack.back().node};
+}
+
+// Constructors
+
+/** Default constructor, same as 0.0 children = {} */
+template <typename T>
+compact_trie<T>::compact_trie()
+    : m_nodes(1, node{0.0, 0, 0, leaf_kind, T{}}), m_n4(), m_n16(), m_n48(), m_n256() {}
+
+/**
+ * Builds the compact layout of a trie.
+ * Nodes are numbered in BFS order, so siblings are contiguous in memory.
+ * @param t the trie to convert
+*/
+template <typename T>
+compact_trie<T>::compact_trie(trie<T> const& t)
+    : m_nodes(), m_n4(), m_n16(), m_n48(), m_n256(){
+    std::vector<trie<T> const*> queue{&t};
+    this->m_nodes.push_back(node{t.get_weight(), 0, 0, leaf_kind, T{}});
+    std::vector<index_type> children;
+    for(std::size_t i = 0; i < queue.size(); ++i){
+        children.clear();
+        for(auto it = queue[i]->get_children().begin(); it != queue[i]->get_children().end(); ++it){
+            children.push_back(static_cast<index_type>(this->m_nodes.size()));
+            this->m_nodes.push_back(node{it->get_weight(), 0, 0, leaf_kind, *(it->get_label())});
+            queue.push_back(&(*it));
+        }
+        if(!children.empty()) this->set_children(static_cast<index_type>(i), children);
+    }
+}
+
+/**
+ * Chooses the smallest node kind able to hold the children and fills it
+ * @param n the parent node
+ * @param children the children, sorted by label
+*/
+template <typename T>
+void compact_trie<T>::set_children(index_type n, std::vector<index_type> const& children){
+    node& p = this->m_nodes[n];
+    p.n = static_cast<std::uint16_t>(children.size());
+    if(children.size() <= 4){
+        node4 c{};
+        for(std::size_t i = 0; i < children.size(); ++i){
+            c.key[i] = key_of(this->m_nodes[children[i]].l);
+            c.child[i] = children[i];
+        }
+        p.k = kind4;
+        p.c = static_cast<index_type>(this->m_n4.size());
+        this->m_n4.push_back(c);
+    }else if(children.size() <= 16){
+        node16 c{};
+        for(std::size_t i = 0; i < children.size(); ++i){
+            c.key[i] = key_of(this->m_nodes[children[i]].l);
+            c.child[i] = children[i];
+        }
+        p.k = kind16;
+        p.c = static_cast<index_type>(this->m_n16.size());
+        this->m_n16.push_back(c);
+    }else if(children.size() <= 48){
+        node48 c{};
+        for(std::size_t i = 0; i < children.size(); ++i){
+            c.slot[key_of(this->m_nodes[children[i]].l)] = static_cast<std::uint8_t>(i + 1);
+            c.child[i] = children[i];
+        }
+        p.k = kind48;
+        p.c = static_cast<index_type>(this->m_n48.size());
+        this->m_n48.push_back(c);
+    }else{
+        node256 c{};
+        for(std::size_t i = 0; i < children.size(); ++i){
+            c.child[key_of(this->m_nodes[children[i]].l)] = children[i];
+        }
+        p.k = kind256;
+        p.c = static_cast<index_type>(this->m_n256.size());
+        this->m_n256.push_back(c);
+    }
+}
+
+/**
+ * Maps a label to a byte key with the same ordering of operator< on T
+ * (signed types are shifted so that negative values come first)
+*/
+template <typename T>
+std::uint8_t compact_trie<T>::key_of(T l){
+    return static_cast<std::uint8_t>(static_cast<std::uint8_t>(l) ^ (std::is_signed<T>::value ? 0x80 : 0x00));
+}
+
+/**
+ * Searches the child with a given key
+ * @return The index of the child, 0 if absent
+*/
+template <typename T>
+typename compact_trie<T>::index_type compact_trie<T>::find_child(index_type n, std::uint8_t key) const{
+    node const& p = this->m_nodes[n];
+    switch(p.k){
+        case kind4: {
+            node4 const& c = this->m_n4[p.c];
+            for(unsigned i = 0; i < p.n && c.key[i] <= key; ++i){
+                if(c.key[i] == key) return c.child[i];
+            }
+            return 0;
+        }
+        case kind16: {
+            node16 const& c = this->m_n16[p.c];
+            for(unsigned i = 0; i < p.n && c.key[i] <= key; ++i){
+                if(c.key[i] == key) return c.child[i];
+            }
+            return 0;
+        }
+        case kind48: {
+            node48 const& c = this->m_n48[p.c];
+            return c.slot[key] ? c.child[c.slot[key] - 1] : 0;
+        }
+        case kind256:
+            return this->m_n256[p.c].child[key];
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Returns the first child in label order at a position >= pos
+ * @param n the parent node
+ * @param pos position to start from, updated with the position of the child
+ * @return The index of the child, 0 if there are no more children
+*/
+template <typename T>
+typename compact_trie<T>::index_type compact_trie<T>::child_at(index_type n, unsigned& pos) const{
+    node const& p = this->m_nodes[n];
+    switch(p.k){
+        case kind4:
+            return pos < p.n ? this->m_n4[p.c].child[pos] : 0;
+        case kind16:
+            return pos < p.n ? this->m_n16[p.c].child[pos] : 0;
+        case kind48: {
+            node48 const& c = this->m_n48[p.c];
+            while(pos < 256 && !c.slot[pos]) ++pos;
+            return pos < 256 ? c.child[c.slot[pos] - 1] : 0;
+        }
+        case kind256: {
+            node256 const& c = this->m_n256[p.c];
+            while(pos < 256 && !c.child[pos]) ++pos;
+            return pos < 256 ? c.child[pos] : 0;
+        }
+        default:
+            return 0;
+    }
+}
+
+// Conversion
+
+/**
+ * Rebuilds the generic trie
+ * @return The trie<T> with the same sequences and weights
+*/
+template <typename T>
+trie<T> compact_trie<T>::expand() const{
+    trie<T> t{this->m_nodes[0].w};
+    this->expand_into(0, t);
+    return t;
+}
+
+/** Adds to t the children of the node n (recursively) */
+template <typename T>
+void compact_trie<T>::expand_into(index_type n, trie<T>& t) const{
+    unsigned pos = 0;
+    for(index_type c = this->child_at(n, pos); c; c = this->child_at(n, ++pos)){
+        trie<T> child{this->m_nodes[c].w};
+        T label = this->m_nodes[c].l;
+        child.set_label(&label);
+        // Add the child while it is still a leaf, then fill it in place to avoid deep copies
+        t.add_child(child);
+        this->expand_into(c, t[std::vector<T>{label}]);
+    }
+}
+
+// Accessors
+
+/** Returns a reference to the root */
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::root() const{
+    return {this, 0};
+}
+
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::operator[](std::vector<T> const& s) const{
+    return this->root()[s];
+}
+
+template <typename T>
+typename compact_trie<T>::node_ref compact_trie<T>::max() const{
+    return this->root().max();
+}
+
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator compact_trie<T>::begin() const{
+    return this->root().begin();
+}
+
+template <typename T>
+typename compact_trie<T>::const_leaf_iterator compact_trie<T>::end() const{
+    return this->root().end();
+}
+
+/** Returns the number of nodes */
+template <typename T>
+std::size_t compact_trie<T>::size() const{
+    return this->m_nodes.size();
+}
+
+/** Returns the bytes used by the node arrays */
+template <typename T>
+std::size_t compact_trie<T>::bytes() const{
+    return this->m_nodes.size() * sizeof(node) + this->m_n4.size() * sizeof(node4)
+        + this->m_n16.size() * sizeof(node16) + this->m_n48.size() * sizeof(node48)
+        + this->m_n256.size() * sizeof(node256);
+}
+
+// Comparison
+
+template <typename T>
+bool compact_trie<T>::operator==(compact_trie<T> const& rhs) const{
+    return this->equal(0, rhs, 0);
+}
+
+template <typename T>
+bool compact_trie<T>::operator!=(compact_trie<T> const& rhs) const{
+    return !(*this == rhs);
+}
+
+/** Compares the sub-trie a of this with the sub-trie b of rhs */
+template <typename T>
+bool compact_trie<T>::equal(index_type a, compact_trie<T> const& rhs, index_type b) const{
+    node const& x = this->m_nodes[a];
+    node const& y = rhs.m_nodes[b];
+    if(x.k == leaf_kind && y.k == leaf_kind) return x.w == y.w;
+    if(x.n != y.n) return false;
+    unsigned pos_a = 0;
+    unsigned pos_b = 0;
+    index_type c_a = this->child_at(a, pos_a);
+    index_type c_b = rhs.child_at(b, pos_b);
+    while(c_a && c_b){
+        if(!(this->m_nodes[c_a].l == rhs.m_nodes[c_b].l) || !this->equal(c_a, rhs, c_b)) return false;
+        c_a = this->child_at(a, ++pos_a);
+        c_b = rhs.child_at(b, ++pos_b);
+    }
+    return !c_a && !c_b;
+}
+
+// Stream operators
+
+/**
+ * Writes on a stream an indented compact trie, same format of trie<T>
+ * @param os the stream to write on
+ * @param n the node to print
+ * @param depth depth of the node, to calculate the tabs
+ * @return written os
+*/
+template <typename T>
+std::ostream& print_indented(std::ostream& os, typename compact_trie<T>::node_ref n, std::size_t depth){
+    if(n.get_label()) os << *(n.get_label()) << " ";
+    if(n.is_leaf()){
+        os << n.get_weight() << " children = {}";
+        return os;
+    }
+    os << "children = {\n";
+    auto children = n.children();
+    for(std::size_t i = 0; i < children.size(); ++i){
+        for(std::size_t d = 0; d <= depth; ++d) os << "    ";
+        print_indented<T>(os, children[i], depth + 1);
+        if(i + 1 < children.size()) os << ",\n";
+    }
+    os << "\n";
+    for(std::size_t d = 0; d < depth; ++d) os << "    ";
+    os << "}";
+    return os;
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os, compact_trie<T> const& t){
+    print_indented<T>(os, t.root(), 0);
+    os << "\n";
+    return os;
+}
+
+/**
+ * Parses a .tr stream with the grammar of trie<T> and compacts it
+ * @param is the stream to read from
+ * @param t the compact trie to be written
+ * @return is read
+*/
+template <typename T>
+std::istream& operator>>(std::istream& is, compact_trie<T>& t){
+    trie<T> parsed;
+    is >> parsed;
+    t = compact_trie<T>{parsed};
+    return is;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef CONCURRENT_TRIE_CPP
+#define CONCURRENT_TRIE_CPP
+
+#include <functional>
+#include <thread>
+
+#include "concurrent_trie.hpp"
+
+// Read guard
+
+template <typename T>
+concurrent_trie<T>::read_guard::read_guard(concurrent_trie<T> const* owner, unsigned slot, trie<T> const* t)
+    : m_owner(owner), m_slot(slot), m_t(t) {}
+
+template <typename T>
+concurrent_trie<T>::read_guard::read_guard(read_guard&& rhs)
+    : m_owner(rhs.m_owner), m_slot(rhs.m_slot), m_t(rhs.m_t){
+    rhs.m_owner = nullptr;
+}
+
+/** Leaves the epoch, the version can be reclaimed */
+template <typename T>
+concurrent_trie<T>::read_guard::~read_guard(){
+    if(this->m_owner) this->m_owner->m_slots[this->m_slot].epoch.store(0);
+}
+
+template <typename T>
+trie<T> const& concurrent_trie<T>::read_guard::operator*() const{
+    return *(this->m_t);
+}
+
+template <typename T>
+trie<T> const* concurrent_trie<T>::read_guard::operator->() const{
+    return this->m_t;
+}
+
+// Constructors
+
+/**
+ * Creates the two instances from a trie
+ * @param t the initial content
+ * @param max_readers max number of guards alive at the same time
+*/
+template <typename T>
+concurrent_trie<T>::concurrent_trie(trie<T> const& t, unsigned max_readers)
+    : m_max_readers(max_readers ? max_readers : 1), m_slots(new slot[max_readers ? max_readers : 1]), m_epoch(1),
+      m_left(new trie<T>{t}), m_right(new trie<T>{t}), m_front(nullptr), m_back(nullptr), m_log(), m_write(){
+    for(unsigned i = 0; i < this->m_max_readers; ++i) this->m_slots[i].epoch.store(0);
+    this->m_front.store(this->m_left.get());
+    this->m_back = this->m_right.get();
+}
+
+template <typename T>
+concurrent_trie<T>::~concurrent_trie() {}
+
+// Readers
+
+/**
+ * Announces the epoch in a free slot(CAS from 0), starting from a slot chosen by thread
+ * @return The index of the slot
+*/
+template <typename T>
+unsigned concurrent_trie<T>::pin(std::uint64_t epoch) const{
+    unsigned start = static_cast<unsigned>(std::hash<std::thread::id>{}(std::this_thread::get_id()) % this->m_max_readers);
+    while(true){
+        for(unsigned i = 0; i < this->m_max_readers; ++i){
+            unsigned s = (start + i) % this->m_max_readers;
+            std::uint64_t free = 0;
+            if(this->m_slots[s].epoch.load() == 0 && this->m_slots[s].epoch.compare_exchange_strong(free, epoch)) return s;
+        }
+        // More than max_readers guards alive
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * Pins the published version: the epoch is announced before loading the pointer,
+ * so the writer won't touch the loaded instance until the guard is released
+ * @return The guard of the version
+*/
+template <typename T>
+typename concurrent_trie<T>::read_guard concurrent_trie<T>::read() const{
+    unsigned s = this->pin(this->m_epoch.load());
+    return read_guard{this, s, this->m_front.load()};
+}
+
+// Writer
+
+/** Applies f to the writer instance and publishes it */
+template <typename T>
+void concurrent_trie<T>::update(std::function<void(trie<T>&)> f){
+    this->stage(std::move(f));
+    this->publish();
+}
+
+/**
+ * Applies f to the writer instance, readers will see it at the next publish().
+ * If f throws, the writer instance is rebuilt from the published one and
+ * the log(f may have changed part of it), f is dropped and the exception
+ * goes to the caller: the two instances never diverge.
+*/
+template <typename T>
+void concurrent_trie<T>::stage(std::function<void(trie<T>&)> f){
+    std::lock_guard<std::mutex> lock{this->m_write};
+    // Logging f must not fail once it is applied
+    this->m_log.reserve(this->m_log.size() + 1);
+    try{
+        f(*(this->m_back));
+    }catch(...){
+        *(this->m_back) = *(this->m_front.load());
+        for(auto& g : this->m_log) g(*(this->m_back));
+        throw;
+    }
+    this->m_log.push_back(std::move(f));
+}
+
+/** Inserts a sequence(see insert_sequence) and publishes it */
+template <typename T>
+void concurrent_trie<T>::insert(std::vector<T> const& s, double w){
+    this->update([s, w](trie<T>& t){ insert_sequence(t, s, w); });
+}
+
+/**
+ * Makes the staged updates visible: swaps the instances, waits for the readers
+ * of the old one and replays the log on it
+*/
+template <typename T>
+void concurrent_trie<T>::publish(){
+    std::lock_guard<std::mutex> lock{this->m_write};
+    if(this->m_log.empty()) return;
+    trie<T>* old = this->m_front.exchange(this->m_back);
+    // Readers announcing this epoch or a later one have loaded the new instance
+    std::uint64_t retired = this->m_epoch.fetch_add(1) + 1;
+    this->wait_readers(retired);
+    for(auto& f : this->m_log) f(*old);
+    this->m_log.clear();
+    this->m_back = old;
+}
+
+/** Number of staged updates */
+template <typename T>
+std::size_t concurrent_trie<T>::pending() const{
+    return this->m_log.size();
+}
+
+/** Waits until no reader is in an epoch older than epoch */
+template <typename T>
+void concurrent_trie<T>::wait_readers(std::uint64_t epoch) const{
+    for(unsigned i = 0; i < this->m_max_readers; ++i){
+        while(true){
+            std::uint64_t e = this->m_slots[i].epoch.load();
+            if(e == 0 || e >= epoch) break;
+            std::this_thread::yield();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef DAWG_CPP
+#define DAWG_CPP
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "flat_trie.cpp"
+#include "dawg.hpp"
+
+// Constructors
+
+/** Empty graph: a root leaf of weight 0, as trie<T>() */
+template <typename T>
+dawg<T>::dawg() : m_states{state{0.0, 0.0, 0, 0}}, m_edges(), m_labels(), m_root(0) {}
+
+template <typename T>
+std::size_t dawg<T>::signature_hash::operator()(std::vector<std::uint64_t> const& s) const{
+    return std::hash<std::string_view>{}(std::string_view{reinterpret_cast<char const*>(s.data()), s.size() * sizeof(std::uint64_t)});
+}
+
+/**
+ * Builds the minimized graph of a trie: its nodes are visited in post order
+ * (explicit stack) and every node is replaced by the state of its signature,
+ * created the first time the signature is seen
+ * @param t the trie
+*/
+template <typename T>
+dawg<T>::dawg(trie<T> const& t) : m_states(), m_edges(), m_labels(), m_root(0){
+    using children_iterator = typename bag<trie<T>>::const_iterator;
+    struct frame {
+        trie<T> const* node;
+        children_iterator next;
+        std::size_t first;  // its children' states start here in done
+    };
+
+    std::unordered_map<T, index_type> labels;
+    std::unordered_map<std::vector<std::uint64_t>, index_type, signature_hash> signatures;
+    std::vector<index_type> done;  // states of the visited children of the open nodes
+    std::vector<std::uint64_t> signature;
+    std::vector<frame> stack{{&t, t.get_children().begin(), 0}};
+    while(!stack.empty()){
+        frame& top = stack.back();
+        if(top.next != top.node->get_children().end()){
+            trie<T> const* child = &(*(top.next));
+            ++(top.next);
+            std::size_t first = done.size();
+            stack.push_back({child, child->get_children().begin(), first});
+            continue;
+        }
+
+        trie<T> const* node = top.node;
+        std::size_t first = top.first;
+        stack.pop_back();
+        signature.clear();
+        state s{node->get_weight(), node->get_weight(), 0, 0};
+        if(node->get_children().empty()){
+            // 0.0 == -0.0 for operator==, they must be the same state
+            double w = s.w == 0.0 ? 0.0 : s.w;
+            std::uint64_t bits = 0;
+            std::memcpy(&bits, &w, sizeof(bits));
+            signature.push_back(0);
+            signature.push_back(bits);
+        }else{
+            signature.push_back(1);
+            std::size_t i = first;
+            for(auto it = node->get_children().begin(); it != node->get_children().end(); ++it, ++i){
+                auto l = labels.find(*(it->get_label()));
+                if(l == labels.end()){
+                    l = labels.emplace(*(it->get_label()), static_cast<index_type>(this->m_labels.size())).first;
+                    this->m_labels.push_back(*(it->get_label()));
+                }
+                signature.push_back(l->second);
+                signature.push_back(done[i]);
+            }
+        }
+
+        auto found = signatures.find(signature);
+        index_type id;
+        if(found != signatures.end()){
+            id = found->second;
+        }else{
+            id = static_cast<index_type>(this->m_states.size());
+            if(!node->get_children().empty()){
+                s.first = static_cast<index_type>(this->m_edges.size());
+                s.count = static_cast<index_type>(done.size() - first);
+                for(std::size_t i = first; i < done.size(); ++i){
+                    index_type target = done[i];
+                    this->m_edges.push_back(edge{static_cast<index_type>(signature[1 + 2 * (i - first)]), target});
+                    if(i == first || this->m_states[target].max > s.max) s.max = this->m_states[target].max;
+                }
+            }
+            this->m_states.push_back(s);
+            signatures.emplace(signature, id);
+        }
+        done.resize(first);
+        done.push_back(id);
+    }
+    this->m_root = done.back();
+}
+
+template <typename T>
+dawg<T> minimize(trie<T> const& t){
+    return dawg<T>{t};
+}
+
+/** Copies the graph back in a trie */
+template <typename T>
+trie<T> dawg<T>::expand() const{
+    trie<T> t;
+    this->expand_into(this->m_root, t);
+    return t;
+}
+
+template <typename T>
+void dawg<T>::expand_into(index_type s, trie<T>& t) const{
+    state const& st = this->m_states[s];
+    t.set_weight(st.w);
+    for(index_type e = st.first; e < st.first + st.count; ++e){
+        trie<T> child;
+        this->expand_into(this->m_edges[e].target, child);
+        T label = this->m_labels[this->m_edges[e].label];
+        child.set_label(&label);
+        // Move the subtree in the bag, add_child would copy it
+        t.get_children().add_ordered(std::move(child), &t);
+    }
+}
+
+/**
+ * Finds the edge of a state with a label(edges are sorted)
+ * @return The edge index, or the end of the edges of s if absent
+*/
+template <typename T>
+typename dawg<T>::index_type dawg<T>::find_edge(index_type s, T const& label) const{
+    state const& st = this->m_states[s];
+    return find_sorted_edge(st.first, st.count, label, [this](index_type e) -> T const& { return this->m_labels[this->m_edges[e].label]; });
+}
+
+// Read API
+
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::root() const{
+    return node_ref{this, this->m_root, no_label};
+}
+
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::operator[](std::vector<T> const& s) const{
+    return this->root()[s];
+}
+
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::max() const{
+    return this->root().max();
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator dawg<T>::begin() const{
+    return this->root().begin();
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator dawg<T>::end() const{
+    return this->root().end();
+}
+
+template <typename T>
+std::size_t dawg<T>::states() const{
+    return this->m_states.size();
+}
+
+template <typename T>
+std::size_t dawg<T>::edges() const{
+    return this->m_edges.size();
+}
+
+/** Bytes of the states, of the edges and of the interned labels */
+template <typename T>
+std::size_t dawg<T>::bytes() const{
+    return this->m_states.size() * sizeof(state) + this->m_edges.size() * sizeof(edge) + this->m_labels.size() * sizeof(T);
+}
+
+// Node reference
+
+template <typename T>
+dawg<T>::node_ref::node_ref(dawg<T> const* d, index_type state, index_type label) : m_d(d), m_state(state), m_label(label) {}
+
+template <typename T>
+double dawg<T>::node_ref::get_weight() const{
+    return this->m_d->m_states[this->m_state].w;
+}
+
+template <typename T>
+T const* dawg<T>::node_ref::get_label() const{
+    return this->m_label == no_label ? nullptr : &(this->m_d->m_labels[this->m_label]);
+}
+
+template <typename T>
+bool dawg<T>::node_ref::is_leaf() const{
+    return this->m_d->m_states[this->m_state].count == 0;
+}
+
+template <typename T>
+std::size_t dawg<T>::node_ref::children_count() const{
+    return this->m_d->m_states[this->m_state].count;
+}
+
+template <typename T>
+std::vector<typename dawg<T>::node_ref> dawg<T>::node_ref::children() const{
+    std::vector<node_ref> result;
+    state const& st = this->m_d->m_states[this->m_state];
+    for(index_type e = st.first; e < st.first + st.count; ++e){
+        result.push_back(node_ref{this->m_d, this->m_d->m_edges[e].target, this->m_d->m_edges[e].label});
+    }
+    return result;
+}
+
+/** Same as trie<T>::operator[]: the last node reached by the sequence */
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::node_ref::operator[](std::vector<T> const& s) const{
+    node_ref reached = *this;
+    for(auto const& l : s){
+        index_type e = this->m_d->find_edge(reached.m_state, l);
+        state const& st = this->m_d->m_states[reached.m_state];
+        if(e == st.first + st.count) break;
+        reached = node_ref{this->m_d, this->m_d->m_edges[e].target, this->m_d->m_edges[e].label};
+    }
+    return reached;
+}
+
+/**
+ * Same as trie<T>::max(): the first leaf in lexicographic order with max
+ * weight, following the first child with the max of the state
+*/
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::node_ref::max() const{
+    node_ref reached = *this;
+    while(!reached.is_leaf()){
+        state const& st = this->m_d->m_states[reached.m_state];
+        index_type e = st.first;
+        while(this->m_d->m_states[this->m_d->m_edges[e].target].max != st.max) ++e;
+        reached = node_ref{this->m_d, this->m_d->m_edges[e].target, this->m_d->m_edges[e].label};
+    }
+    return reached;
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator dawg<T>::node_ref::begin() const{
+    return const_leaf_iterator{this->m_d, this->m_state, this->m_label, false};
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator dawg<T>::node_ref::end() const{
+    return const_leaf_iterator{this->m_d, this->m_state, this->m_label, true};
+}
+
+template <typename T>
+bool dawg<T>::node_ref::operator==(node_ref const& rhs) const{
+    return this->m_d == rhs.m_d && this->m_state == rhs.m_state;
+}
+
+template <typename T>
+bool dawg<T>::node_ref::operator!=(node_ref const& rhs) const{
+    return !(*this == rhs);
+}
+
+// Leaf iterator
+
+template <typename T>
+dawg<T>::const_leaf_iterator::const_leaf_iterator(dawg<T> const* d, index_type start, index_type label, bool end)
+    : m_d(d), m_start(start), m_start_label(label), m_stack(), m_end(end){
+    if(!end && d->m_states[start].count > 0){
+        this->m_stack.push_back(frame{start, d->m_states[start].first});
+        this->descend();
+    }
+}
+
+/** Goes down the first edges to a leaf */
+template <typename T>
+void dawg<T>::const_leaf_iterator::descend(){
+    while(true){
+        index_type target = this->m_d->m_edges[this->m_stack.back().pos].target;
+        state const& st = this->m_d->m_states[target];
+        if(st.count == 0) return;
+        this->m_stack.push_back(frame{target, st.first});
+    }
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator::reference dawg<T>::const_leaf_iterator::operator*() const{
+    T const* l = this->operator->();
+    if(!l) throw parser_exception{"No label for the root"};
+    return *l;
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator::pointer dawg<T>::const_leaf_iterator::operator->() const{
+    return this->get_leaf().get_label();
+}
+
+/** Moves to the next leaf in lexicographic order */
+template <typename T>
+typename dawg<T>::const_leaf_iterator& dawg<T>::const_leaf_iterator::operator++(){
+    if(this->m_end) return *this;
+    while(!this->m_stack.empty()){
+        frame& top = this->m_stack.back();
+        state const& st = this->m_d->m_states[top.state];
+        if(++(top.pos) < st.first + st.count){
+            this->descend();
+            return *this;
+        }
+        this->m_stack.pop_back();
+    }
+    this->m_end = true;
+    return *this;
+}
+
+template <typename T>
+typename dawg<T>::const_leaf_iterator dawg<T>::const_leaf_iterator::operator++(int){
+    const_leaf_iterator old = *this;
+    ++(*this);
+    return old;
+}
+
+/** Iterators are equal if they followed the same path(leaves are shared) */
+template <typename T>
+bool dawg<T>::const_leaf_iterator::operator==(const_leaf_iterator const& rhs) const{
+    if(this->m_end || rhs.m_end) return this->m_end == rhs.m_end;
+    if(this->m_stack.size() != rhs.m_stack.size()) return false;
+    for(std::size_t i = 0; i < this->m_stack.size(); ++i){
+        if(this->m_stack[i].pos != rhs.m_stack[i].pos) return false;
+    }
+    return this->m_start == rhs.m_start;
+}
+
+template <typename T>
+bool dawg<T>::const_leaf_iterator::operator!=(const_leaf_iterator const& rhs) const{
+    return !(*this == rhs);
+}
+
+template <typename T>
+typename dawg<T>::node_ref dawg<T>::const_leaf_iterator::get_leaf() const{
+    if(this->m_end) throw parser_exception{"No leaf pointed"};
+    if(this->m_stack.empty()) return node_ref{this->m_d, this->m_start, this->m_start_label};
+    edge const& e = this->m_d->m_edges[this->m_stack.back().pos];
+    return node_ref{this->m_d, e.target, e.label};
+}
+
+template <typename T>
+std::vector<T> dawg<T>::const_leaf_iterator::sequence() const{
+    if(this->m_end) throw parser_exception{"No leaf pointed"};
+    std::vector<T> s;
+    for(auto const& f : this->m_stack) s.push_back(this->m_d->m_labels[this->m_d->m_edges[f.pos].label]);
+    return s;
+}
+
+#endif
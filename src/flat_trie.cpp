@@ -0,0 +1,90 @@
+#ifndef FLAT_TRIE_CPP
+#define FLAT_TRIE_CPP
+
+#include "flat_trie.hpp"
+
+template <typename Index, typename T, typename LabelOf>
+Index find_sorted_edge(Index first, Index count, T const& label, LabelOf label_of){
+    Index lo = first;
+    Index hi = first + count;
+    while(lo < hi){
+        Index mid = lo + (hi - lo) / 2;
+        T const& l = label_of(mid);
+        if(l == label) return mid;
+        if(l < label) lo = mid + 1;
+        else hi = mid;
+    }
+    return first + count;
+}
+
+// Constructors
+
+/** The root alone, a leaf of weight 0 as trie<T>() */
+template <typename T>
+flat_trie<T>::flat_trie() : m_nodes{node{0, 0, 0.0}}, m_edges() {}
+
+/**
+ * Copies a trie breadth first
+ * @param t the trie, its root is the node 0
+*/
+template <typename T>
+flat_trie<T>::flat_trie(trie<T> const& t) : m_nodes{node{0, 0, t.get_weight()}}, m_edges() {
+    std::vector<trie<T> const*> queue{&t};  // trie node of every node
+    for(index_type n = 0; n < queue.size(); ++n){
+        bag<trie<T>> const& children = queue[n]->get_children();
+        this->m_nodes[n].first = static_cast<index_type>(this->m_edges.size());
+        for(auto it = children.begin(); it != children.end(); ++it){
+            this->m_edges.push_back(edge{*(it->get_label()), static_cast<index_type>(queue.size())});
+            this->m_nodes.push_back(node{0, 0, it->get_weight()});
+            queue.push_back(&(*it));
+            ++(this->m_nodes[n].count);
+        }
+    }
+}
+
+// Read API
+
+template <typename T>
+typename flat_trie<T>::node const& flat_trie<T>::get_node(index_type n) const{
+    return this->m_nodes[n];
+}
+
+template <typename T>
+typename flat_trie<T>::edge const& flat_trie<T>::get_edge(index_type e) const{
+    return this->m_edges[e];
+}
+
+template <typename T>
+bool flat_trie<T>::is_leaf(index_type n) const{
+    return this->m_nodes[n].count == 0;
+}
+
+template <typename T>
+double flat_trie<T>::get_weight(index_type n) const{
+    return this->m_nodes[n].w;
+}
+
+template <typename T>
+typename flat_trie<T>::index_type flat_trie<T>::child(index_type n, T const& label) const{
+    node const& nd = this->m_nodes[n];
+    index_type e = find_sorted_edge(nd.first, nd.count, label, [this](index_type i) -> T const& { return this->m_edges[i].label; });
+    return e == nd.first + nd.count ? no_node : this->m_edges[e].target;
+}
+
+template <typename T>
+std::size_t flat_trie<T>::nodes() const{
+    return this->m_nodes.size();
+}
+
+template <typename T>
+std::size_t flat_trie<T>::edges() const{
+    return this->m_edges.size();
+}
+
+/** Bytes of the arrays(labels counted by sizeof(T)) */
+template <typename T>
+std::size_t flat_trie<T>::bytes() const{
+    return this->m_nodes.size() * sizeof(node) + this->m_edges.size() * sizeof(edge);
+}
+
+#endif
@@ -0,0 +1,398 @@
+#ifndef LAZY_TRIE_CPP
+#define LAZY_TRIE_CPP
+
+#include <limits>
+#include <sstream>
+#include <type_traits>
+
+#include "lazy_trie.hpp"
+
+// Writing
+
+template <typename V>
+void write_raw(std::ostream& os, V const& v){
+    os.write(reinterpret_cast<char const*>(&v), sizeof(V));
+}
+
+template <typename V>
+V read_raw(std::istream& is){
+    V v{};
+    is.read(reinterpret_cast<char*>(&v), sizeof(V));
+    if(!is) throw parser_exception{"Truncated indexed file"};
+    return v;
+}
+
+/* labels: the bytes of a trivially copyable T */
+template <typename T>
+void write_label(std::ostream& os, T const& l, std::true_type){
+    write_raw(os, l);
+}
+
+template <typename T>
+void read_label(std::istream& is, T& l, std::true_type){
+    l = read_raw<T>(is);
+}
+
+/* other labels: the text of operator<<, with the digits to read a double back */
+template <typename T>
+void write_label(std::ostream& os, T const& l, std::false_type){
+    std::ostringstream text;
+    text.precision(std::numeric_limits<double>::max_digits10);
+    text << l;
+    write_raw(os, static_cast<std::uint32_t>(text.str().size()));
+    os.write(text.str().data(), text.str().size());
+}
+
+template <typename T>
+void read_label(std::istream& is, T& l, std::false_type){
+    std::string text(read_raw<std::uint32_t>(is), '\0');
+    is.read(&text[0], text.size());
+    std::istringstream label{text};
+    label >> l;
+    if(label.fail()) throw parser_exception{"The label can't be parsed as type T"};
+}
+
+/* strings: the length and the characters, blanks included */
+inline void write_label(std::ostream& os, std::string const& l){
+    write_raw(os, static_cast<std::uint32_t>(l.size()));
+    os.write(l.data(), l.size());
+}
+
+inline void read_label(std::istream& is, std::string& l){
+    l.resize(read_raw<std::uint32_t>(is));
+    is.read(&l[0], l.size());
+    if(!is) throw parser_exception{"Truncated indexed file"};
+}
+
+template <typename T>
+void write_label(std::ostream& os, T const& l){
+    write_label(os, l, std::is_trivially_copyable<T>{});
+}
+
+template <typename T>
+void read_label(std::istream& is, T& l){
+    read_label(is, l, std::is_trivially_copyable<T>{});
+}
+
+/* what a parent stores about a written child */
+struct indexed_child {
+    std::uint64_t offset;
+    double max;
+    bool leaf;
+};
+
+/**
+ * Writes the records of a sub-trie, children first. A leaf has no record:
+ * its entry in the parent keeps its weight(as its max) and its own offset.
+*/
+template <typename T>
+indexed_child write_record(std::ostream& os, trie<T> const& t){
+    if(t.get_children().empty()) return indexed_child{0, t.get_weight(), true};
+    std::vector<indexed_child> children;
+    double max = 0.0;
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        children.push_back(write_record(os, *it));
+        if(children.size() == 1 || children.back().max > max) max = children.back().max;
+    }
+    std::uint64_t offset = static_cast<std::uint64_t>(os.tellp());
+    write_raw(os, t.get_weight());
+    write_raw(os, static_cast<std::uint32_t>(children.size()));
+    std::size_t i = 0;
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it, ++i){
+        std::uint64_t entry = static_cast<std::uint64_t>(os.tellp());
+        write_label(os, *(it->get_label()));
+        write_raw(os, children[i].leaf ? entry : children[i].offset);
+        write_raw(os, children[i].max);
+        write_raw(os, static_cast<std::uint8_t>(children[i].leaf));
+    }
+    return indexed_child{offset, max, false};
+}
+
+template <typename T>
+std::ostream& write_indexed(std::ostream& os, trie<T> const& t){
+    std::streampos start = os.tellp();
+    // Header placeholder, the root is known at the end
+    os.write("TRI2", 4);
+    write_raw(os, std::uint64_t{0});
+    write_raw(os, 0.0);
+    write_raw(os, std::uint8_t{0});
+    indexed_child root = write_record(os, t);
+    std::streampos after = os.tellp();
+    os.seekp(start + std::streamoff(4));
+    write_raw(os, root.offset);
+    write_raw(os, root.max);
+    write_raw(os, static_cast<std::uint8_t>(root.leaf));
+    os.seekp(after);
+    return os;
+}
+
+// Lazy trie
+
+/**
+ * Opens an indexed file reading its header only
+ * @param path the file
+ * @param cache_records max number of records kept in memory
+*/
+template <typename T>
+lazy_trie<T>::lazy_trie(std::string const& path, std::size_t cache_records)
+    : m_file(path, std::ios::binary), m_root(), m_capacity(cache_records ? cache_records : 1), m_lru(), m_cache(), m_reads(0){
+    if(!this->m_file) throw parser_exception{"Can't open the indexed file"};
+    char magic[4] = {0, 0, 0, 0};
+    this->m_file.read(magic, 4);
+    if(!this->m_file || std::string(magic, 4) != "TRI2") throw parser_exception{"Not an indexed trie file"};
+    this->m_root.label = nullptr;
+    this->m_root.offset = read_raw<std::uint64_t>(this->m_file);
+    this->m_root.max = read_raw<double>(this->m_file);
+    this->m_root.leaf = read_raw<std::uint8_t>(this->m_file) != 0;
+}
+
+/**
+ * Returns the record at offset, from the cache or from the file
+ * (evicting the least recently used one when the cache is full)
+*/
+template <typename T>
+std::shared_ptr<typename lazy_trie<T>::record const> lazy_trie<T>::load(std::uint64_t offset) const{
+    auto found = this->m_cache.find(offset);
+    if(found != this->m_cache.end()){
+        this->m_lru.splice(this->m_lru.begin(), this->m_lru, found->second.second);
+        return found->second.first;
+    }
+    ++(this->m_reads);
+    this->m_file.clear();
+    this->m_file.seekg(static_cast<std::streamoff>(offset));
+    auto r = std::make_shared<record>();
+    r->weight = read_raw<double>(this->m_file);
+    std::uint32_t n = read_raw<std::uint32_t>(this->m_file);
+    r->children.reserve(n);
+    for(std::uint32_t i = 0; i < n; ++i){
+        T label;
+        read_label(this->m_file, label);
+        child_entry e;
+        e.label = std::make_shared<T const>(label);
+        e.offset = read_raw<std::uint64_t>(this->m_file);
+        e.max = read_raw<double>(this->m_file);
+        e.leaf = read_raw<std::uint8_t>(this->m_file) != 0;
+        r->children.push_back(std::move(e));
+    }
+    if(this->m_cache.size() >= this->m_capacity){
+        this->m_cache.erase(this->m_lru.back());
+        this->m_lru.pop_back();
+    }
+    this->m_lru.push_front(offset);
+    this->m_cache[offset] = {r, this->m_lru.begin()};
+    return r;
+}
+
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::root() const{
+    return node_ref{this, this->m_root};
+}
+
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::operator[](std::vector<T> const& s) const{
+    return this->root()[s];
+}
+
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::max() const{
+    return this->root().max();
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator lazy_trie<T>::begin() const{
+    return this->root().begin();
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator lazy_trie<T>::end() const{
+    return this->root().end();
+}
+
+/** Number of records in the cache */
+template <typename T>
+std::size_t lazy_trie<T>::cached() const{
+    return this->m_cache.size();
+}
+
+/** Number of records read from the file */
+template <typename T>
+std::size_t lazy_trie<T>::reads() const{
+    return this->m_reads;
+}
+
+// Node reference
+
+template <typename T>
+lazy_trie<T>::node_ref::node_ref(lazy_trie<T> const* t, child_entry const& e) : m_t(t), m_entry(e) {}
+
+/** The weight, a leaf has no record: its parent keeps it */
+template <typename T>
+double lazy_trie<T>::node_ref::get_weight() const{
+    return this->m_entry.leaf ? this->m_entry.max : this->m_t->load(this->m_entry.offset)->weight;
+}
+
+template <typename T>
+T const* lazy_trie<T>::node_ref::get_label() const{
+    return this->m_entry.label.get();
+}
+
+template <typename T>
+bool lazy_trie<T>::node_ref::is_leaf() const{
+    return this->m_entry.leaf;
+}
+
+template <typename T>
+std::size_t lazy_trie<T>::node_ref::children_count() const{
+    return this->m_entry.leaf ? 0 : this->m_t->load(this->m_entry.offset)->children.size();
+}
+
+template <typename T>
+std::vector<typename lazy_trie<T>::node_ref> lazy_trie<T>::node_ref::children() const{
+    std::vector<node_ref> result;
+    if(this->m_entry.leaf) return result;
+    auto r = this->m_t->load(this->m_entry.offset);
+    for(auto const& e : r->children) result.push_back(node_ref{this->m_t, e});
+    return result;
+}
+
+/** Same as trie<T>::operator[]: the last node reached by the sequence */
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::node_ref::operator[](std::vector<T> const& s) const{
+    node_ref reached = *this;
+    for(auto const& l : s){
+        if(reached.m_entry.leaf) break;
+        auto r = this->m_t->load(reached.m_entry.offset);
+        child_entry const* next = nullptr;
+        for(auto const& e : r->children){
+            if(*(e.label) == l){
+                next = &e;
+                break;
+            }
+        }
+        if(!next) break;
+        reached = node_ref{this->m_t, *next};
+    }
+    return reached;
+}
+
+/**
+ * Same as trie<T>::max(): the first leaf in lexicographic order with max weight.
+ * Follows the first child with the max of the node, reading one path only.
+*/
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::node_ref::max() const{
+    node_ref reached = *this;
+    while(!reached.m_entry.leaf){
+        auto r = this->m_t->load(reached.m_entry.offset);
+        child_entry const* best = &(r->children.front());
+        for(auto const& e : r->children){
+            if(e.max > best->max) best = &e;
+        }
+        reached = node_ref{this->m_t, *best};
+    }
+    return reached;
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator lazy_trie<T>::node_ref::begin() const{
+    return const_leaf_iterator{this->m_t, this->m_entry, false};
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator lazy_trie<T>::node_ref::end() const{
+    return const_leaf_iterator{this->m_t, this->m_entry, true};
+}
+
+/** Reads the whole sub-trie into a trie<T> */
+template <typename T>
+trie<T> lazy_trie<T>::node_ref::materialize() const{
+    trie<T> t{this->get_weight()};
+    for(auto const& child : this->children()){
+        trie<T> sub = child.materialize();
+        T label = *(child.get_label());
+        sub.set_label(&label);
+        // Move the subtree in the bag, add_child would copy it
+        t.get_children().add_ordered(std::move(sub), &t);
+    }
+    return t;
+}
+
+// Leaf iterator
+
+template <typename T>
+lazy_trie<T>::const_leaf_iterator::const_leaf_iterator(lazy_trie<T> const* t, child_entry const& start, bool end)
+    : m_t(t), m_start(start), m_stack(), m_end(end){
+    if(!end && !start.leaf){
+        this->m_stack.push_back(frame{t->load(start.offset), 0});
+        this->descend();
+    }
+}
+
+/** Goes down to the first leaf below the current position */
+template <typename T>
+void lazy_trie<T>::const_leaf_iterator::descend(){
+    while(true){
+        child_entry const& e = this->m_stack.back().node->children[this->m_stack.back().pos];
+        if(e.leaf) return;
+        this->m_stack.push_back(frame{this->m_t->load(e.offset), 0});
+    }
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator::reference lazy_trie<T>::const_leaf_iterator::operator*() const{
+    T const* l = this->operator->();
+    if(!l) throw parser_exception{"No label for the root"};
+    return *l;
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator::pointer lazy_trie<T>::const_leaf_iterator::operator->() const{
+    if(this->m_end) throw parser_exception{"No leaf pointed"};
+    if(this->m_stack.empty()) return this->m_start.label.get();
+    return this->m_stack.back().node->children[this->m_stack.back().pos].label.get();
+}
+
+/** Moves to the next leaf in lexicographic order */
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator& lazy_trie<T>::const_leaf_iterator::operator++(){
+    if(this->m_end) return *this;
+    while(!this->m_stack.empty()){
+        frame& top = this->m_stack.back();
+        if(++(top.pos) < top.node->children.size()){
+            this->descend();
+            return *this;
+        }
+        this->m_stack.pop_back();
+    }
+    this->m_end = true;
+    return *this;
+}
+
+template <typename T>
+typename lazy_trie<T>::const_leaf_iterator lazy_trie<T>::const_leaf_iterator::operator++(int){
+    const_leaf_iterator old = *this;
+    ++(*this);
+    return old;
+}
+
+template <typename T>
+bool lazy_trie<T>::const_leaf_iterator::operator==(const_leaf_iterator const& rhs) const{
+    if(this->m_end || rhs.m_end) return this->m_end == rhs.m_end;
+    // The offset of a leaf is the one of its entry, even if the records on the path were reloaded
+    return this->get_leaf().m_entry.offset == rhs.get_leaf().m_entry.offset;
+}
+
+template <typename T>
+bool lazy_trie<T>::const_leaf_iterator::operator!=(const_leaf_iterator const& rhs) const{
+    return !(*this == rhs);
+}
+
+/** Returns the leaf pointed */
+template <typename T>
+typename lazy_trie<T>::node_ref lazy_trie<T>::const_leaf_iterator::get_leaf() const{
+    if(this->m_end) throw parser_exception{"No leaf pointed"};
+    if(this->m_stack.empty()) return node_ref{this->m_t, this->m_start};
+    return node_ref{this->m_t, this->m_stack.back().node->children[this->m_stack.back().pos]};
+}
+
+#endif
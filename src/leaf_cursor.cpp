@@ -0,0 +1,109 @@
+#ifndef LEAF_CURSOR_CPP
+#define LEAF_CURSOR_CPP
+
+#include "leaf_cursor.hpp"
+
+// Sequence view
+
+template <typename T>
+T const* sequence_view<T>::begin() const{
+    return this->data;
+}
+
+template <typename T>
+T const* sequence_view<T>::end() const{
+    return this->data + this->size;
+}
+
+template <typename T>
+T const& sequence_view<T>::operator[](std::size_t i) const{
+    return this->data[i];
+}
+
+template <typename T>
+bool sequence_view<T>::empty() const{
+    return this->size == 0;
+}
+
+template <typename T>
+std::vector<T> sequence_view<T>::to_vector() const{
+    return std::vector<T>(this->begin(), this->end());
+}
+
+// Cursor
+
+template <typename T>
+leaf_cursor<T>::leaf_cursor(trie<T> const& t) : m_root(&t), m_stack(), m_labels(), m_started(false) {}
+
+template <typename T>
+void leaf_cursor<T>::reset(){
+    this->m_stack.clear();
+    this->m_started = false;
+}
+
+/** Adds a child to the path, reusing the slot of its label */
+template <typename T>
+void leaf_cursor<T>::push(trie<T> const& child){
+    std::size_t slot = this->m_stack.size() - 1;
+    if(slot < this->m_labels.size()) this->m_labels[slot] = *(child.get_label());
+    else this->m_labels.push_back(*(child.get_label()));
+    this->m_stack.push_back(frame{&child, child.get_children().begin()});
+}
+
+/** Follows the first children from the top of the path down to a leaf */
+template <typename T>
+void leaf_cursor<T>::descend(){
+    while(this->m_stack.back().next != this->m_stack.back().node->get_children().end()){
+        trie<T> const& child = *(this->m_stack.back().next);
+        ++(this->m_stack.back().next);
+        this->push(child);
+    }
+}
+
+template <typename T>
+bool leaf_cursor<T>::next(){
+    if(!this->m_started){
+        this->m_started = true;
+        this->m_stack.push_back(frame{this->m_root, this->m_root->get_children().begin()});
+        this->descend();
+        return true;
+    }
+    if(this->m_stack.empty()) return false;
+    // Leave the current leaf, then the ancestors with no children left
+    this->m_stack.pop_back();
+    while(!this->m_stack.empty()){
+        frame& top = this->m_stack.back();
+        if(top.next != top.node->get_children().end()){
+            trie<T> const& child = *(top.next);
+            ++(top.next);
+            this->push(child);
+            this->descend();
+            return true;
+        }
+        this->m_stack.pop_back();
+    }
+    return false;
+}
+
+template <typename T>
+sequence_view<T> leaf_cursor<T>::sequence() const{
+    return sequence_view<T>{this->m_labels.data(), this->depth()};
+}
+
+template <typename T>
+double leaf_cursor<T>::weight() const{
+    return this->leaf().get_weight();
+}
+
+template <typename T>
+trie<T> const& leaf_cursor<T>::leaf() const{
+    if(this->m_stack.empty()) throw parser_exception{"No leaf pointed"};
+    return *(this->m_stack.back().node);
+}
+
+template <typename T>
+std::size_t leaf_cursor<T>::depth() const{
+    return this->m_stack.empty() ? 0 : this->m_stack.size() - 1;
+}
+
+#endif
@@ -0,0 +1,401 @@
+#ifndef PERSISTENT_TRIE_CPP
+#define PERSISTENT_TRIE_CPP
+
+#include <utility>
+
+#include "persistent_trie.hpp"
+
+// Cursor
+
+/** Creates a cursor on the root of a version */
+template <typename T>
+persistent_trie<T>::cursor::cursor(persistent_trie<T> const& t)
+    : m_root(t.m_root), m_path{t.m_root.get()}, m_position{0} {}
+
+template <typename T>
+typename persistent_trie<T>::node const& persistent_trie<T>::cursor::current() const{
+    return *(this->m_path.back());
+}
+
+template <typename T>
+double persistent_trie<T>::cursor::get_weight() const{
+    return this->current().w;
+}
+
+template <typename T>
+T const* persistent_trie<T>::cursor::get_label() const{
+    return this->current().label.get();
+}
+
+template <typename T>
+bool persistent_trie<T>::cursor::is_leaf() const{
+    return this->current().children.empty();
+}
+
+template <typename T>
+std::size_t persistent_trie<T>::cursor::children_count() const{
+    return this->current().children.size();
+}
+
+/** Returns the number of labels between the root and the current node */
+template <typename T>
+std::size_t persistent_trie<T>::cursor::depth() const{
+    return this->m_path.size() - 1;
+}
+
+/** Returns the labels from the root to the current node */
+template <typename T>
+std::vector<T> persistent_trie<T>::cursor::sequence() const{
+    std::vector<T> s;
+    for(std::size_t i = 1; i < this->m_path.size(); ++i) s.push_back(*(this->m_path[i]->label));
+    return s;
+}
+
+/**
+ * Moves to the child with a label
+ * @return If the child exists(otherwise the cursor doesn't move)
+*/
+template <typename T>
+bool persistent_trie<T>::cursor::down(T const& label){
+    node const& n = this->current();
+    std::size_t i = persistent_trie<T>::lower_bound(n, label);
+    if(i == n.children.size() || label < *(n.children[i]->label)) return false;
+    this->m_path.push_back(n.children[i].get());
+    this->m_position.push_back(i);
+    return true;
+}
+
+/**
+ * Moves to the first child
+ * @return If the current node has a child
+*/
+template <typename T>
+bool persistent_trie<T>::cursor::down_first(){
+    node const& n = this->current();
+    if(n.children.empty()) return false;
+    this->m_path.push_back(n.children.front().get());
+    this->m_position.push_back(0);
+    return true;
+}
+
+/**
+ * Moves to the next sibling in label order
+ * @return If there is a next sibling
+*/
+template <typename T>
+bool persistent_trie<T>::cursor::next_sibling(){
+    if(this->m_path.size() == 1) return false;
+    node const& parent = *(this->m_path[this->m_path.size() - 2]);
+    std::size_t next = this->m_position.back() + 1;
+    if(next == parent.children.size()) return false;
+    this->m_path.back() = parent.children[next].get();
+    this->m_position.back() = next;
+    return true;
+}
+
+/**
+ * Moves to the parent
+ * @return If the current node isn't the root
+*/
+template <typename T>
+bool persistent_trie<T>::cursor::up(){
+    if(this->m_path.size() == 1) return false;
+    this->m_path.pop_back();
+    this->m_position.pop_back();
+    return true;
+}
+
+// Constructors
+
+/** Default constructor, same as 0.0 children = {} */
+template <typename T>
+persistent_trie<T>::persistent_trie() : persistent_trie(0.0) {}
+
+/** Creates a leaf root with a weight */
+template <typename T>
+persistent_trie<T>::persistent_trie(double w)
+    : m_root(make_node(node{nullptr, w, {}})) {}
+
+/** Builds the first version from a trie */
+template <typename T>
+persistent_trie<T>::persistent_trie(trie<T> const& t) : m_root(build(t)) {}
+
+template <typename T>
+persistent_trie<T>::persistent_trie(node_ptr root) : m_root(std::move(root)) {}
+
+/**
+ * Builds the nodes of a trie in post order(explicit stack, chains can be long)
+ * @return The root of the new nodes
+*/
+template <typename T>
+typename persistent_trie<T>::node_ptr persistent_trie<T>::build(trie<T> const& t){
+    using children_iterator = typename bag<trie<T>>::const_iterator;
+    struct frame {
+        trie<T> const* source;
+        children_iterator next;
+        node n;
+    };
+    std::vector<frame> stack;
+    stack.push_back(frame{&t, t.get_children().begin(), node{nullptr, t.get_weight(), {}}});
+    while(true){
+        frame& top = stack.back();
+        if(top.next != top.source->get_children().end()){
+            trie<T> const& child = *(top.next);
+            ++(top.next);
+            stack.push_back(frame{&child, child.get_children().begin(), node{std::make_shared<T const>(*(child.get_label())), child.get_weight(), {}}});
+            continue;
+        }
+        node_ptr built = make_node(std::move(top.n));
+        stack.pop_back();
+        if(stack.empty()) return built;
+        stack.back().n.children.push_back(std::move(built));
+    }
+}
+
+/**
+ * Allocates a node whose deleter releases the children iteratively:
+ * destroying a long chain would otherwise recurse once per node
+*/
+template <typename T>
+typename persistent_trie<T>::node_ptr persistent_trie<T>::make_node(node&& n){
+    return node_ptr{new node{std::move(n)}, node_deleter{}};
+}
+
+template <typename T>
+void persistent_trie<T>::node_deleter::operator()(node const* n) const{
+    // The outermost deletion of the thread drains the children released by the nested ones
+    static thread_local std::vector<node_ptr>* released = nullptr;
+    std::vector<node_ptr> own;
+    bool outermost = released == nullptr;
+    if(outermost) released = &own;
+    // The node was allocated non-const by make_node
+    for(auto& c : const_cast<node*>(n)->children) released->push_back(std::move(c));
+    delete n;
+    if(!outermost) return;
+    while(!own.empty()){
+        node_ptr c = std::move(own.back());
+        own.pop_back();
+        c.reset();
+    }
+    released = nullptr;
+}
+
+// Versioned updates
+
+/**
+ * Adds a sequence with its weight, as insert_sequence does on trie<T>.
+ * Only the nodes on the path are copied.
+ * @param s the sequence
+ * @param w the weight of the sequence
+ * @return The new version, this one is unchanged
+*/
+template <typename T>
+persistent_trie<T> persistent_trie<T>::insert(std::vector<T> const& s, double w) const{
+    return persistent_trie<T>{copy_path(*(this->m_root), s, w, true)};
+}
+
+/**
+ * Changes the weight of the node reached by a sequence.
+ * Only the nodes on the path are copied.
+ * @param s the sequence, must be in the trie
+ * @param w the new weight
+ * @return The new version, this one is unchanged
+*/
+template <typename T>
+persistent_trie<T> persistent_trie<T>::set_weight(std::vector<T> const& s, double w) const{
+    return persistent_trie<T>{copy_path(*(this->m_root), s, w, false)};
+}
+
+/** Builds the new nodes for the labels of s from i on, with weight w */
+template <typename T>
+typename persistent_trie<T>::node_ptr persistent_trie<T>::chain(std::vector<T> const& s, std::size_t i, double w){
+    node_ptr reached = nullptr;
+    for(std::size_t j = s.size(); j > i; --j){
+        node n{std::make_shared<T const>(s[j - 1]), w, {}};
+        if(reached) n.children.push_back(std::move(reached));
+        reached = make_node(std::move(n));
+    }
+    return reached;
+}
+
+/**
+ * Copies the path of s(explicit stack): the node reached gets the weight w,
+ * every ancestor is copied pointing to the new copy of its child
+ * @param insert if the missing labels are added(insert) or are an error(set_weight)
+ * @return The new root
+*/
+template <typename T>
+typename persistent_trie<T>::node_ptr persistent_trie<T>::copy_path(node const& root, std::vector<T> const& s, double w, bool insert){
+    std::vector<node const*> path{&root};
+    std::vector<std::size_t> positions;  // positions[j]: index of path[j + 1] in path[j]
+    node_ptr reached = nullptr;          // new copy of path.back()
+    for(std::size_t i = 0; i < s.size(); ++i){
+        node const& n = *(path.back());
+        std::size_t c = lower_bound(n, s[i]);
+        if(c == n.children.size() || s[i] < *(n.children[c]->label)){
+            if(!insert) throw parser_exception{"No node pointed"};
+            node copy = n;
+            copy.children.insert(copy.children.begin() + c, chain(s, i, w));
+            reached = make_node(std::move(copy));
+            break;
+        }
+        positions.push_back(c);
+        path.push_back(n.children[c].get());
+    }
+    if(!reached){
+        node copy = *(path.back());
+        if(insert && !copy.children.empty()) throw parser_exception{"The sequence is a prefix of other sequences"};
+        copy.w = w;
+        reached = make_node(std::move(copy));
+    }
+    path.pop_back();
+    while(!path.empty()){
+        node copy = *(path.back());
+        copy.children[positions[path.size() - 1]] = std::move(reached);
+        reached = make_node(std::move(copy));
+        path.pop_back();
+    }
+    return reached;
+}
+
+// Read API
+
+/** Index of the first child with a label not less than label */
+template <typename T>
+std::size_t persistent_trie<T>::lower_bound(node const& n, T const& label){
+    std::size_t lo = 0;
+    std::size_t hi = n.children.size();
+    while(lo < hi){
+        std::size_t mid = (lo + hi) / 2;
+        if(*(n.children[mid]->label) < label){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/** Returns the node reached by s, nullptr if s isn't in the trie */
+template <typename T>
+typename persistent_trie<T>::node const* persistent_trie<T>::find(node const* n, std::vector<T> const& s){
+    for(auto const& l : s){
+        std::size_t c = lower_bound(*n, l);
+        if(c == n->children.size() || l < *(n->children[c]->label)) return nullptr;
+        n = n->children[c].get();
+    }
+    return n;
+}
+
+/** Returns if a sequence(or a prefix of a sequence) is in the trie */
+template <typename T>
+bool persistent_trie<T>::contains(std::vector<T> const& s) const{
+    return find(this->m_root.get(), s) != nullptr;
+}
+
+/** Returns the weight of the node reached by a sequence */
+template <typename T>
+double persistent_trie<T>::get_weight(std::vector<T> const& s) const{
+    node const* n = find(this->m_root.get(), s);
+    if(!n) throw parser_exception{"No node pointed"};
+    return n->w;
+}
+
+/** Returns a cursor on the root */
+template <typename T>
+typename persistent_trie<T>::cursor persistent_trie<T>::root() const{
+    return cursor{*this};
+}
+
+/** Returns the number of nodes of this version(shared nodes included) */
+template <typename T>
+std::size_t persistent_trie<T>::size() const{
+    return count(*(this->m_root));
+}
+
+template <typename T>
+std::size_t persistent_trie<T>::count(node const& n){
+    std::size_t c = 0;
+    std::vector<node const*> stack{&n};
+    while(!stack.empty()){
+        node const* reached = stack.back();
+        stack.pop_back();
+        ++c;
+        for(auto const& child : reached->children) stack.push_back(child.get());
+    }
+    return c;
+}
+
+// Conversion
+
+/**
+ * Rebuilds the generic trie
+ * @return The trie<T> with the same sequences and weights
+*/
+template <typename T>
+trie<T> persistent_trie<T>::expand() const{
+    trie<T> t{this->m_root->w};
+    expand_into(*(this->m_root), t);
+    return t;
+}
+
+/** Adds to t the children of n(explicit stack) */
+template <typename T>
+void persistent_trie<T>::expand_into(node const& n, trie<T>& t){
+    std::vector<std::pair<node const*, trie<T>*>> stack{{&n, &t}};
+    while(!stack.empty()){
+        auto top = stack.back();
+        stack.pop_back();
+        for(auto const& c : top.first->children){
+            trie<T> child{c->w};
+            T label = *(c->label);
+            child.set_label(&label);
+            // Add the child while it is still a leaf, then fill it in place to avoid deep copies
+            top.second->add_child(child);
+            stack.push_back({c.get(), &((*(top.second))[std::vector<T>{label}])});
+        }
+    }
+}
+
+// Comparison
+
+template <typename T>
+bool persistent_trie<T>::operator==(persistent_trie<T> const& rhs) const{
+    return equal(*(this->m_root), *(rhs.m_root));
+}
+
+template <typename T>
+bool persistent_trie<T>::operator!=(persistent_trie<T> const& rhs) const{
+    return !(*this == rhs);
+}
+
+/** Compares two sub-tries, shared nodes are equal without visiting them */
+template <typename T>
+bool persistent_trie<T>::equal(node const& a, node const& b){
+    std::vector<std::pair<node const*, node const*>> stack{{&a, &b}};
+    while(!stack.empty()){
+        node const* x = stack.back().first;
+        node const* y = stack.back().second;
+        stack.pop_back();
+        if(x == y) continue;
+        if(x->children.empty() && y->children.empty()){
+            if(!(x->w == y->w)) return false;
+            continue;
+        }
+        if(x->children.size() != y->children.size()) return false;
+        for(std::size_t i = 0; i < x->children.size(); ++i){
+            if(!(*(x->children[i]->label) == *(y->children[i]->label))) return false;
+            stack.push_back({x->children[i].get(), y->children[i].get()});
+        }
+    }
+    return true;
+}
+
+// Stream operators
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os, persistent_trie<T> const& t){
+    return os << t.expand();
+}
+
+#endif
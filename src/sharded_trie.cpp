@@ -0,0 +1,239 @@
+#ifndef SHARDED_TRIE_CPP
+#define SHARDED_TRIE_CPP
+
+#include <algorithm>
+#include <functional>
+
+#include "sharded_trie.hpp"
+
+// Leaf iterator
+
+/**
+ * Creates an iterator on the first leaf of the children of the merged root from next on
+ * @param roots the children of the merged root, sorted by label
+ * @param next the first child to visit, roots->size() for the end
+*/
+template <typename T>
+sharded_trie<T>::const_leaf_iterator::const_leaf_iterator(std::shared_ptr<std::vector<trie<T> const*> const> roots, std::size_t next)
+    : m_roots(std::move(roots)), m_next(next), m_stack(), m_leaf(nullptr){
+    if(this->m_next < this->m_roots->size()) this->descend((*this->m_roots)[this->m_next++]);
+}
+
+/** Goes down to the first leaf of t, keeping the siblings to visit */
+template <typename T>
+void sharded_trie<T>::const_leaf_iterator::descend(trie<T> const* t){
+    while(!t->get_children().empty()){
+        auto it = t->get_children().begin();
+        frame f{it, t->get_children().end()};
+        t = &(*(f.it));
+        ++(f.it);
+        this->m_stack.push_back(f);
+    }
+    this->m_leaf = t;
+}
+
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator::reference sharded_trie<T>::const_leaf_iterator::operator*() const{
+    return *(this->get_leaf().get_label());
+}
+
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator::pointer sharded_trie<T>::const_leaf_iterator::operator->() const{
+    return this->get_leaf().get_label();
+}
+
+/** Moves to the next leaf in lexicographic order */
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator& sharded_trie<T>::const_leaf_iterator::operator++(){
+    while(!this->m_stack.empty() && this->m_stack.back().it == this->m_stack.back().end) this->m_stack.pop_back();
+    if(!this->m_stack.empty()){
+        trie<T> const* next = &(*(this->m_stack.back().it));
+        ++(this->m_stack.back().it);
+        this->descend(next);
+    }else if(this->m_next < this->m_roots->size()){
+        this->descend((*this->m_roots)[this->m_next++]);
+    }else{
+        this->m_leaf = nullptr;
+    }
+    return *this;
+}
+
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator sharded_trie<T>::const_leaf_iterator::operator++(int){
+    const_leaf_iterator old = *this;
+    ++(*this);
+    return old;
+}
+
+template <typename T>
+bool sharded_trie<T>::const_leaf_iterator::operator==(const_leaf_iterator const& rhs) const{
+    return this->m_leaf == rhs.m_leaf;
+}
+
+template <typename T>
+bool sharded_trie<T>::const_leaf_iterator::operator!=(const_leaf_iterator const& rhs) const{
+    return !(*this == rhs);
+}
+
+/** Returns the leaf pointed */
+template <typename T>
+trie<T> const& sharded_trie<T>::const_leaf_iterator::get_leaf() const{
+    if(!this->m_leaf) throw parser_exception{"No leaf pointed"};
+    return *(this->m_leaf);
+}
+
+// Constructors
+
+/**
+ * Creates an empty sharded trie
+ * @param shards number of shards(and of locks)
+*/
+template <typename T>
+sharded_trie<T>::sharded_trie(unsigned shards)
+    : m_count(shards ? shards : 1), m_shards(new shard[shards ? shards : 1]) {}
+
+/** Returns the shard of the sequences starting with label */
+template <typename T>
+typename sharded_trie<T>::shard& sharded_trie<T>::shard_of(T const& label) const{
+    return this->m_shards[std::hash<T>{}(label) % this->m_count];
+}
+
+/** Returns the number of shards */
+template <typename T>
+std::size_t sharded_trie<T>::shards() const{
+    return this->m_count;
+}
+
+// Thread safe access
+
+/**
+ * Adds a sequence with its weight(see insert_sequence), locking only its shard
+ * @param s the sequence, not empty
+ * @param w the weight of the sequence
+*/
+template <typename T>
+void sharded_trie<T>::insert(std::vector<T> const& s, double w){
+    if(s.empty()) throw parser_exception{"Empty sequence"};
+    shard& sh = this->shard_of(s.front());
+    std::lock_guard<std::mutex> lock{sh.lock};
+    insert_sequence(sh.t, s, w);
+}
+
+/** Returns if a sequence(or a prefix of a sequence) is in the trie */
+template <typename T>
+bool sharded_trie<T>::contains(std::vector<T> const& s) const{
+    if(s.empty()) return true;
+    shard& sh = this->shard_of(s.front());
+    std::lock_guard<std::mutex> lock{sh.lock};
+    return this->find(s) != nullptr;
+}
+
+/** Returns the weight of the node reached by a sequence */
+template <typename T>
+double sharded_trie<T>::get_weight(std::vector<T> const& s) const{
+    if(s.empty()) throw parser_exception{"Empty sequence"};
+    shard& sh = this->shard_of(s.front());
+    std::lock_guard<std::mutex> lock{sh.lock};
+    trie<T> const* t = this->find(s);
+    if(!t) throw parser_exception{"No node pointed"};
+    return t->get_weight();
+}
+
+/** Returns the node reached by s, nullptr if s isn't in its shard */
+template <typename T>
+trie<T> const* sharded_trie<T>::find(std::vector<T> const& s) const{
+    trie<T> const* t = &(this->shard_of(s.front()).t);
+    for(auto const& l : s){
+        trie<T> const* child = nullptr;
+        for(auto it = t->get_children().begin(); !child && it != t->get_children().end(); ++it){
+            if(*(it->get_label()) == l) child = &(*it);
+        }
+        if(!child) return nullptr;
+        t = child;
+    }
+    return t;
+}
+
+// Merged view
+
+/**
+ * Returns the sub-trie reached by a sequence: the last node found if the
+ * sequence isn't complete in the trie. Unlike trie<T>::operator[] there is
+ * no merged root node to return, so an empty sequence or a missing first
+ * label throw parser_exception where trie<T> returns the root.
+ * @param s the sequence, its first label must be in the trie
+*/
+template <typename T>
+trie<T> const& sharded_trie<T>::operator[](std::vector<T> const& s) const{
+    if(s.empty()) throw parser_exception{"Empty sequence"};
+    trie<T> const& t = this->shard_of(s.front()).t;
+    trie<T> const& reached = t[s];
+    if(&reached == &t) throw parser_exception{"No node pointed"};
+    return reached;
+}
+
+/**
+ * Returns the leaf with max weight, the first one in lexicographic order on ties
+ * (the same returned by max() on the frozen trie). Without sequences it
+ * throws parser_exception, where max() of the frozen trie returns its root.
+*/
+template <typename T>
+trie<T> const& sharded_trie<T>::max() const{
+    trie<T> const* max = nullptr;
+    T const* max_first = nullptr;
+    for(unsigned i = 0; i < this->m_count; ++i){
+        trie<T> const& t = this->m_shards[i].t;
+        if(t.get_children().empty()) continue;
+        trie<T> const* candidate = &(t.max());
+        // First label of the candidate, to break ties between shards
+        trie<T> const* first = candidate;
+        while(first->get_parent() != &t) first = first->get_parent();
+        if(!max || candidate->get_weight() > max->get_weight()
+            || (candidate->get_weight() == max->get_weight() && *(first->get_label()) < *max_first)){
+            max = candidate;
+            max_first = first->get_label();
+        }
+    }
+    if(!max) throw parser_exception{"No leaf pointed"};
+    return *max;
+}
+
+/** Returns an iterator on the first leaf of the merged view */
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator sharded_trie<T>::begin() const{
+    auto roots = std::make_shared<std::vector<trie<T> const*>>();
+    for(unsigned i = 0; i < this->m_count; ++i){
+        trie<T> const& t = this->m_shards[i].t;
+        for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it) roots->push_back(&(*it));
+    }
+    std::sort(roots->begin(), roots->end(), [](trie<T> const* a, trie<T> const* b){
+        return *(a->get_label()) < *(b->get_label());
+    });
+    return const_leaf_iterator{roots, 0};
+}
+
+/** Returns the iterator past the last leaf */
+template <typename T>
+typename sharded_trie<T>::const_leaf_iterator sharded_trie<T>::end() const{
+    return const_leaf_iterator{std::make_shared<std::vector<trie<T> const*>>(), 0};
+}
+
+// Freeze
+
+/**
+ * Relinks the children of every shard under one trie(no node is copied).
+ * Must not run concurrently with the other members.
+ * @return The trie with all the sequences
+*/
+template <typename T>
+trie<T> sharded_trie<T>::freeze(){
+    trie<T> frozen;
+    for(unsigned i = 0; i < this->m_count; ++i){
+        std::lock_guard<std::mutex> lock{this->m_shards[i].lock};
+        // First labels are disjoint between shards
+        frozen.get_children().merge_ordered(this->m_shards[i].t.get_children(), &frozen);
+    }
+    return frozen;
+}
+
+#endif
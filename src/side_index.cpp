@@ -0,0 +1,131 @@
+#ifndef SIDE_INDEX_CPP
+#define SIDE_INDEX_CPP
+
+#include "side_index.hpp"
+
+// Constructors
+
+/** Indexes nothing yet: the index builds its entries once constructed */
+template <typename T, typename Entry, typename Index>
+side_index<T, Entry, Index>::side_index(trie<T>& t) : m_t(&t), m_entries() {}
+
+template <typename T, typename Entry, typename Index>
+Index& side_index<T, Entry, Index>::self(){
+    return static_cast<Index&>(*this);
+}
+
+/** Recomputes the index of the whole trie */
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::rebuild(){
+    this->m_entries.clear();
+    this->self().build(*(this->m_t));
+}
+
+template <typename T, typename Entry, typename Index>
+trie<T> const& side_index<T, Entry, Index>::get_trie() const{
+    return *(this->m_t);
+}
+
+// Entries
+
+template <typename T, typename Entry, typename Index>
+Entry const* side_index<T, Entry, Index>::find(trie<T> const& t) const{
+    auto e = this->m_entries.find(&t);
+    return e == this->m_entries.end() ? nullptr : &(e->second);
+}
+
+/** Removes the entries of a sub-trie */
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::forget(trie<T> const& t){
+    // t can be a leaf that was an inner node
+    this->m_entries.erase(&t);
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it) this->forget(*it);
+}
+
+/** Recomputes the entries of the ancestors of t, up to the indexed root */
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::update_path(trie<T> const& t){
+    trie<T> const* reached = &t;
+    while(reached != this->m_t && reached->get_parent()){
+        reached = reached->get_parent();
+        this->self().update_entry(*reached);
+    }
+}
+
+// Mutations
+
+/**
+ * Adds a child(trie<T>::add_child) and updates the path to the root
+ * @param parent a node of the indexed trie
+ * @param child the child to copy
+*/
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::add_child(trie<T>& parent, trie<T> const& child){
+    parent.add_child(child);
+    this->self().build(parent[std::vector<T>{*(child.get_label())}]);
+    this->self().update_entry(parent);
+    this->update_path(parent);
+}
+
+/**
+ * Changes the weight of a leaf and updates the path to the root
+ * @param leaf a leaf of the indexed trie
+ * @param w the new weight
+*/
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::set_weight(trie<T>& leaf, double w){
+    leaf.set_weight(w);
+    this->update_path(leaf);
+}
+
+/**
+ * Adds rhs to the trie(operator+=) and recomputes only the sub-tries it
+ * changed: the children of the root with a label of a child of rhs. The
+ * merge reassigns those children, their old nodes are destroyed.
+ * @param rhs the trie to add
+ * @return The index
+*/
+template <typename T, typename Entry, typename Index>
+Index& side_index<T, Entry, Index>::operator+=(trie<T> const& rhs){
+    trie<T>& t = *(this->m_t);
+    if(t.get_children().empty() || rhs.get_children().empty()){
+        // Every leaf can change
+        t += rhs;
+        this->rebuild();
+        return this->self();
+    }
+    std::vector<T> touched;
+    for(auto it = rhs.get_children().begin(); it != rhs.get_children().end(); ++it){
+        std::vector<T> s{*(it->get_label())};
+        trie<T> const& child = t[s];
+        if(&child != &t) this->forget(child);
+        touched.push_back(s.front());
+    }
+    t += rhs;
+    for(auto const& l : touched) this->self().build(t[std::vector<T>{l}]);
+    this->self().update_entry(t);
+    return this->self();
+}
+
+/**
+ * Compresses the trie(trie<T>::path_compress). The leaves don't change but
+ * the compressed nodes are reassigned, so the index is rebuilt(O(n)).
+*/
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::path_compress(){
+    this->m_t->path_compress();
+    this->rebuild();
+}
+
+/**
+ * Recomputes a sub-trie changed without the index, and the path to the root
+ * @param sub a node of the indexed trie
+*/
+template <typename T, typename Entry, typename Index>
+void side_index<T, Entry, Index>::refresh(trie<T> const& sub){
+    this->forget(sub);
+    this->self().build(sub);
+    this->update_path(sub);
+}
+
+#endif
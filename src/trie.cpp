@@ -30,6 +30,7 @@ trie<T>::trie(trie<T> const& rhs)
     : m_c(rhs.m_c){
     this->m_p = nullptr;
     if(rhs.m_l){
+        TRIE_COUNT(allocations);
         this->m_l = new T{*(rhs.m_l)};
     }else{
         this->m_l = nullptr;
@@ -102,6 +103,7 @@ void trie<T>::set_label(T* l){
     // First delete the prev label
     if(this->m_l) delete this->m_l;
     // Duplicate the ptr
+    TRIE_COUNT(allocations);
     T* new_l = new T{(*l)};
     this->m_l = new_l;
 }
@@ -170,6 +172,8 @@ bag<trie<T>>& trie<T>::get_children() {
 
 template <typename T>
 bool trie<T>::operator==(trie<T> const& rhs) const{
+    TRIE_COUNT(subtree_comparisons);
+    if(this == &rhs) return true;
     // Two tries are equal if: 
     // - 2 leaves(=>no children) && same weight
     // - Have same children 
@@ -182,6 +186,7 @@ bool trie<T>::operator==(trie<T> const& rhs) const{
 
 template <typename T>
 bool trie<T>::operator!=(trie<T> const& rhs) const{
+    TRIE_COUNT(subtree_comparisons);
     // Two tries are not equal if: 
     // - 2 leaves(=>no children) && not same weight
     // - Not same children 
@@ -201,6 +206,7 @@ bool trie<T>::operator!=(trie<T> const& rhs) const{
 */
 template <typename T>
 trie<T>& trie<T>::operator[](std::vector<T> const& s){
+    TRIE_OP_SCOPE(lookup);
     /** 
      * Pointer to the reached trie.
      * PS: can't do a reference because references can't change the referenced obj
@@ -214,6 +220,8 @@ trie<T>& trie<T>::operator[](std::vector<T> const& s){
         auto it = reached_trie->m_c.begin();
         bool found = false;
         while (!found && it != reached_trie->m_c.end()){
+            TRIE_COUNT(nodes_visited);
+            TRIE_COUNT(label_comparisons);
             if(*((*it).get_label()) == s.at(next_label)){
                 found = true;
             }else{
@@ -238,6 +246,7 @@ trie<T>& trie<T>::operator[](std::vector<T> const& s){
 */
 template <typename T>
 trie<T> const& trie<T>::operator[](std::vector<T> const& s) const{
+    TRIE_OP_SCOPE(lookup);
     /** 
      * Pointer to the reached trie.
      * PS: can't do a reference because references can't change the referenced obj
@@ -251,6 +260,8 @@ trie<T> const& trie<T>::operator[](std::vector<T> const& s) const{
         auto it = reached_trie->m_c.begin();
         bool found = false;
         while (!found && it != reached_trie->m_c.end()){
+            TRIE_COUNT(nodes_visited);
+            TRIE_COUNT(label_comparisons);
             if(*((*it).get_label()) == s.at(next_label)){
                 found = true;
             }else{
@@ -276,6 +287,7 @@ trie<T> const& trie<T>::operator[](std::vector<T> const& s) const{
 */
 template <typename T>
 trie<T>& trie<T>::max(){
+    TRIE_OP_SCOPE(max);
     leaf_iterator it{this};
     trie<T>* max = &(this->begin().get_leaf());
     ++it;
@@ -294,6 +306,7 @@ trie<T>& trie<T>::max(){
 */
 template <typename T>
 trie<T> const& trie<T>::max() const{
+    TRIE_OP_SCOPE(max);
     const_leaf_iterator it{this};
     const trie<T>* max = &(this->begin().get_leaf());
     ++it;
@@ -520,14 +533,17 @@ typename trie<T>::leaf_iterator::pointer trie<T>::leaf_iterator::operator->() co
 */
 template <typename T>
 typename trie<T>::leaf_iterator& trie<T>::leaf_iterator::operator++(){
+    TRIE_OP_SCOPE(leaf_next);
     trie<T>* next_node = nullptr;
     // Search the next leaf in the children until find a valid one or reach the root
     while(!next_node && this->m_ptr->m_p){
-        trie<T> actual_leaf = this->get_leaf();
         auto it = this->m_ptr->m_p->m_c.begin();
         bool found = false;
         while(!found && it != this->m_ptr->m_p->m_c.end()){
-            if(*((*it).get_label()) == *(actual_leaf.get_label()) && *it == actual_leaf){
+            TRIE_COUNT(nodes_visited);
+            // The actual node is a child of its father: find it by address,
+            // comparing labels and subtrees would copy and visit the subtree
+            if(&(*it) == this->m_ptr){
                 found = true;
             }
             ++it;
@@ -614,6 +630,7 @@ typename trie<T>::leaf_iterator trie<T>::begin(){
 */
 template <typename T>
 typename trie<T>::leaf_iterator trie<T>::end(){
+    TRIE_OP_SCOPE(end);
     trie<T>* next_node = nullptr;
     // The end leaf is the first one of the next node so go at the father and reach the next node of this
     if(this->m_p){
@@ -624,7 +641,9 @@ typename trie<T>::leaf_iterator trie<T>::end(){
             auto it = father_node->m_c.begin();
             bool found = false;
             while(!found && it != father_node->m_c.end()){
-                if(*((*it).get_label()) == *(actual_leaf->get_label()) && *it == *actual_leaf){
+                TRIE_COUNT(nodes_visited);
+                // Find the actual node by address, as in leaf_iterator::operator++
+                if(&(*it) == actual_leaf){
                     found = true;
                 }
                 ++it;
@@ -688,14 +707,17 @@ typename trie<T>::const_leaf_iterator::pointer trie<T>::const_leaf_iterator::ope
 */
 template <typename T>
 typename trie<T>::const_leaf_iterator& trie<T>::const_leaf_iterator::operator++(){
+    TRIE_OP_SCOPE(leaf_next);
     trie<T>* next_node = nullptr;
     // Search the next leaf in the children until find a valid one or reach the root
     while(!next_node && this->m_ptr->m_p){
-        trie<T> actual_leaf = this->get_leaf();
         auto it = this->m_ptr->m_p->m_c.begin();
         bool found = false;
         while(!found && it != this->m_ptr->m_p->m_c.end()){
-            if(*((*it).get_label()) == *(actual_leaf.get_label()) && *it == actual_leaf){
+            TRIE_COUNT(nodes_visited);
+            // The actual node is a child of its father: find it by address,
+            // comparing labels and subtrees would copy and visit the subtree
+            if(&(*it) == this->m_ptr){
                 found = true;
             }
             ++it;
@@ -782,6 +804,7 @@ typename trie<T>::const_leaf_iterator trie<T>::begin() const{
 */
 template <typename T>
 typename trie<T>::const_leaf_iterator trie<T>::end() const{
+    TRIE_OP_SCOPE(end);
     trie<T>* next_node = nullptr;
     // The end leaf is the first one of the next node so go at the father and reach the next node of this
     if(this->m_p){
@@ -792,7 +815,9 @@ typename trie<T>::const_leaf_iterator trie<T>::end() const{
             auto it = father_node->m_c.begin();
             bool found = false;
             while(!found && it != father_node->m_c.end()){
-                if(*((*it).get_label()) == *(actual_leaf->get_label()) && *it == *actual_leaf){
+                TRIE_COUNT(nodes_visited);
+                // Find the actual node by address, as in leaf_iterator::operator++
+                if(&(*it) == actual_leaf){
                     found = true;
                 }
                 ++it;
@@ -919,6 +944,9 @@ void leaf(std::istream& is, trie<T>& t){
     }
 }
 
+template <typename T>
+void sibling(std::istream& is, trie<T>& t);
+
 /**
  * Parse a NODE from an input stream
  * @param is the stream to read from
@@ -927,6 +955,24 @@ void leaf(std::istream& is, trie<T>& t){
 */
 template <typename T>
 void node(std::istream& is, trie<T>& t){
+    // NODE, NODE is read in a loop, a long list of siblings would overflow the stack
+    char next = 0;
+    do{
+        sibling(is, t);
+        skip_blank_spaces(is);
+        next = 0;
+        is >> next;
+    }while(next == ',');
+    is.putback(next);
+}
+
+/**
+ * Parse a single NODE(LABEL LEAF | LABEL children = {NODE}) from an input stream
+ * @param is the stream to read from
+ * @param t the trie to be written
+*/
+template <typename T>
+void sibling(std::istream& is, trie<T>& t){
     skip_blank_spaces(is);
     // Any node has the label, try to parse it
     T label;
@@ -938,8 +984,10 @@ void node(std::istream& is, trie<T>& t){
         trie<T> leaf_to_add;
         leaf(is, leaf_to_add);
         leaf_to_add.set_label(&label);
-        leaf_to_add.set_parent(&t);
-        t.add_child(leaf_to_add);
+        // Move the child in the bag, add_child would copy it
+        if(!t.get_children().add_ordered(std::move(leaf_to_add), &t)){
+            throw parser_exception{"There is already a child with same label"};
+        }
     }else{ // NODE
         // Try to read children = {NODE}
         std::string s = "";
@@ -956,24 +1004,15 @@ void node(std::istream& is, trie<T>& t){
         trie<T> node_to_add;
         node(is, node_to_add);
         node_to_add.set_label(&label);
-        node_to_add.set_parent(&t);
-        t.add_child(node_to_add);
+        // Move the subtree in the bag, add_child would copy it
+        if(!t.get_children().add_ordered(std::move(node_to_add), &t)){
+            throw parser_exception{"There is already a child with same label"};
+        }
         
         skip_blank_spaces(is);
         is >> c;
         if (c != '}') throw parser_exception{"Expected keyword '}'"};
     }
-
-    // Check for NODE, NODE
-    skip_blank_spaces(is);
-    char c = 0;
-    is >> c;
-    if(c == ','){
-        node(is, t);
-    }else{
-        is.putback(c);
-    }
-
 }
 
 // Read from stream
@@ -991,6 +1030,7 @@ void node(std::istream& is, trie<T>& t){
  */
 template <typename T>
 std::istream& operator>>(std::istream& is, trie<T>& t){
+    TRIE_OP_SCOPE(parse);
     trie<T> new_trie;
     skip_blank_spaces(is);
     char c = is.peek();
@@ -1019,11 +1059,43 @@ std::istream& operator>>(std::istream& is, trie<T>& t){
     skip_blank_spaces(is);
     if(is.peek() != EOF) throw parser_exception{"Unexpected char detected"};
 
-    t = new_trie;
+    t = std::move(new_trie);
 
     return is;
 }
 
+// Insertion of a sequence
+
+/**
+ * Adds a sequence with its weight: the missing nodes are created and the
+ * reached leaf gets the weight. As for add_child, a leaf on the path loses
+ * its weight when it acquires a child.
+ * @param t the trie
+ * @param s the sequence
+ * @param w the weight of the sequence
+ * @return The leaf of the sequence
+*/
+template <typename T>
+trie<T>& insert_sequence(trie<T>& t, std::vector<T> const& s, double w){
+    trie<T>* reached = &t;
+    for(auto const& l : s){
+        std::vector<T> next{l};
+        trie<T>* child = &((*reached)[next]);
+        if(child == reached){
+            // Missing label: move a new leaf in the bag and take it back
+            trie<T> leaf_to_add{w};
+            T label = l;
+            leaf_to_add.set_label(&label);
+            reached->get_children().add_ordered(std::move(leaf_to_add), reached);
+            child = &((*reached)[next]);
+        }
+        reached = child;
+    }
+    if(!reached->get_children().empty()) throw parser_exception{"The sequence is a prefix of other sequences"};
+    reached->set_weight(w);
+    return *reached;
+}
+
 // Facultative: union
 
 /**
@@ -1033,6 +1105,7 @@ std::istream& operator>>(std::istream& is, trie<T>& t){
 */
 template <typename T>
 trie<T> trie<T>::operator+(trie<T> const& op2) const {
+    TRIE_OP_SCOPE(merge);
     if(this->m_c.empty() && op2.m_c.empty()){ // Both are leaves
         trie<T> result = *this;
         result.m_w += op2.m_w;
@@ -1071,6 +1144,7 @@ trie<T> trie<T>::operator+(trie<T> const& op2) const {
 */
 template <typename T>
 trie<T>& trie<T>::operator+=(trie<T> const& op2) {
+    TRIE_OP_SCOPE(merge);
     if(this->m_c.empty() && op2.m_c.empty()){ // Both are leaves
         this->m_w += op2.m_w;
         return *this;
@@ -1105,10 +1179,12 @@ trie<T>& trie<T>::operator+=(trie<T> const& op2) {
 /** Compress the children with just one children in one trie */
 template <typename T>
 void trie<T>::path_compress(){
+    TRIE_OP_SCOPE(compress);
     if(this->m_c.empty()){ // Leaf
        return;
     }else if(this->m_p && this->m_c.has_one_child()){
         (*(this->m_c.begin())).path_compress();
+        TRIE_COUNT(allocations);
         T* tmp_l = new T{static_cast<T>(*(this->m_l) + *(this->m_c.begin()->m_l))};
         this->set_label(tmp_l);
         delete tmp_l;
@@ -0,0 +1,250 @@
+#ifndef TRIE_EVENTS_CPP
+#define TRIE_EVENTS_CPP
+
+#include <sstream>
+
+#include "trie_events.hpp"
+
+// Parser
+
+template <typename T, typename Handler>
+trie_event_parser<T, Handler>::trie_event_parser(Handler& handler)
+    : m_handler(handler), m_state(root), m_depth(0) {}
+
+template <typename T, typename Handler>
+bool trie_event_parser<T, Handler>::done() const{
+    return this->m_state == trailing || this->m_state == end;
+}
+
+template <typename T, typename Handler>
+bool trie_event_parser<T, Handler>::finished() const{
+    return this->m_state == end;
+}
+
+/** Number of open braces */
+template <typename T, typename Handler>
+std::size_t trie_event_parser<T, Handler>::depth() const{
+    return this->m_depth;
+}
+
+/** Reads "children = {" as operator>> does */
+inline void open_children(std::istream& is){
+    std::string s = "";
+    is >> s;
+    if (s != "children") throw parser_exception{"Expected keyword 'children'"};
+    skip_blank_spaces(is);
+    char c = 0;
+    is >> c;
+    if (c != '=') throw parser_exception{"Expected keyword '='"};
+    skip_blank_spaces(is);
+    c = 0;
+    is >> c;
+    if (c != '{') throw parser_exception{"Expected keyword '{'"};
+}
+
+/** A leaf follows as in operator>>: '-' or a digit */
+inline bool weight_follows(std::istream& is){
+    return is.peek() == '-' || (is.peek() >= '0' && is.peek() <= '9');
+}
+
+/**
+ * Reads the step of the current state
+ * ROOT -> LEAF | children = {NODE}
+ * NODE -> LABEL LEAF | LABEL children = {NODE} | NODE, NODE
+ * LEAF -> WEIGHT children = {}
+ * @param is the stream
+ * @param r where the event and the next state are written
+*/
+template <typename T, typename Handler>
+void trie_event_parser<T, Handler>::read(std::istream& is, result& r) const{
+    r.depth = this->m_depth;
+    r.e = no_event;
+    switch(this->m_state){
+        case root:
+            skip_blank_spaces(is);
+            if(weight_follows(is)){
+                trie<T> l;
+                leaf(is, l);
+                r.e = leaf_event;
+                r.weight = l.get_weight();
+                r.next = trailing;
+            }else{
+                open_children(is);
+                r.depth = 1;
+                r.next = node;
+            }
+            break;
+        case node:
+            skip_blank_spaces(is);
+            is >> r.label;
+            skip_blank_spaces(is);
+            if(is.fail()) throw parser_exception{"The label can't be parsed as type T"};
+            if(weight_follows(is)){
+                trie<T> l;
+                leaf(is, l);
+                r.e = leaf_event;
+                r.weight = l.get_weight();
+                r.next = after_node;
+            }else{
+                open_children(is);
+                r.e = enter_event;
+                ++(r.depth);
+                r.next = node;
+            }
+            break;
+        case after_node: {
+            skip_blank_spaces(is);
+            char c = 0;
+            is >> c;
+            if(c == ','){
+                r.next = node;
+            }else if(c == '}'){
+                --(r.depth);
+                // The root has no label and no event
+                if(r.depth > 0) r.e = exit_event;
+                r.next = r.depth > 0 ? after_node : trailing;
+            }else{
+                throw parser_exception{"Expected keyword '}'"};
+            }
+            break;
+        }
+        case trailing:
+            skip_blank_spaces(is);
+            if(is.peek() != EOF) throw parser_exception{"Unexpected char detected"};
+            r.next = end;
+            break;
+        case end:
+            throw parser_exception{"Unexpected char detected"};
+    }
+}
+
+/**
+ * If a step read past the end of the stream. skip_blank_spaces() puts the
+ * character back, which clears eof: a failed read with nothing left counts.
+*/
+inline bool reached_end(std::istream& is){
+    return is.eof() || (is.fail() && is.rdbuf()->in_avail() <= 0);
+}
+
+template <typename T, typename Handler>
+bool trie_event_parser<T, Handler>::step(std::istream& is, bool last){
+    result r{this->m_state, no_event, this->m_depth, T{}, 0.0};
+    try{
+        this->read(is, r);
+    }catch(parser_exception const&){
+        // The rest of a token can still come
+        if(!last && reached_end(is)) return false;
+        throw;
+    }
+    if(!last && reached_end(is)) return false;
+    this->m_state = r.next;
+    this->m_depth = r.depth;
+    switch(r.e){
+        case enter_event:
+            this->m_handler.on_enter(r.label);
+            break;
+        case leaf_event:
+            this->m_handler.on_leaf(this->m_depth == 0 ? nullptr : &(r.label), r.weight);
+            break;
+        case exit_event:
+            this->m_handler.on_exit();
+            break;
+        case no_event:
+            break;
+    }
+    return true;
+}
+
+template <typename T, typename Handler>
+std::istream& parse_events(std::istream& is, Handler& handler){
+    trie_event_parser<T, Handler> parser{handler};
+    while(!parser.finished()) parser.step(is, true);
+    // Reaching the end is not an error, leave only eof set as operator>> does
+    is.clear(std::ios::eofbit);
+    return is;
+}
+
+// Building a trie
+
+template <typename T>
+trie_builder<T>::trie_builder(trie<T>& t) : m_open{&t} {}
+
+/** Adds a node with children, its children come next */
+template <typename T>
+void trie_builder<T>::on_enter(T const& label){
+    trie<T>& parent = *(this->m_open.back());
+    trie<T> child;
+    T l = label;
+    child.set_label(&l);
+    // Move the child in the bag, add_child would copy it
+    if(!parent.get_children().add_ordered(std::move(child), &parent)){
+        throw parser_exception{"There is already a child with same label"};
+    }
+    this->m_open.push_back(&(parent[std::vector<T>{label}]));
+}
+
+template <typename T>
+void trie_builder<T>::on_leaf(T const* label, double w){
+    trie<T>& parent = *(this->m_open.back());
+    if(!label){
+        parent.set_weight(w);
+        return;
+    }
+    trie<T> leaf_to_add{w};
+    T l = *label;
+    leaf_to_add.set_label(&l);
+    if(!parent.get_children().add_ordered(std::move(leaf_to_add), &parent)){
+        throw parser_exception{"There is already a child with same label"};
+    }
+}
+
+template <typename T>
+void trie_builder<T>::on_exit(){
+    this->m_open.pop_back();
+}
+
+// Incremental parser
+
+template <typename T>
+incremental_parser<T>::incremental_parser()
+    : m_trie(), m_builder(m_trie), m_parser(m_builder), m_pending() {}
+
+/**
+ * Parses a chunk of input
+ * @param data the chunk
+ * @param size its length
+*/
+template <typename T>
+void incremental_parser<T>::feed(char const* data, std::size_t size){
+    this->m_pending.append(data, size);
+    std::istringstream is{this->m_pending};
+    std::size_t read = 0;
+    while(!this->m_parser.finished() && this->m_parser.step(is, false)) read = static_cast<std::size_t>(is.tellg());
+    this->m_pending.erase(0, read);
+}
+
+/**
+ * Ends the input
+ * @return The trie read, errors as operator>> if the input is incomplete
+*/
+template <typename T>
+trie<T> incremental_parser<T>::finish(){
+    std::istringstream is{this->m_pending};
+    while(!this->m_parser.finished()) this->m_parser.step(is, true);
+    this->m_pending.clear();
+    return std::move(this->m_trie);
+}
+
+/** If the input fed so far is a complete trie */
+template <typename T>
+bool incremental_parser<T>::done() const{
+    return this->m_parser.done();
+}
+
+/** The trie built so far(children of the open nodes may still come) */
+template <typename T>
+trie<T> const& incremental_parser<T>::partial() const{
+    return this->m_trie;
+}
+
+#endif
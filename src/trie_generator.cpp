@@ -0,0 +1,284 @@
+#ifndef TRIE_GENERATOR_CPP
+#define TRIE_GENERATOR_CPP
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+#include "trie_generator.hpp"
+
+// Labels
+
+/* distinct labels of a type: text(i) != text(j) if i != j, i and j below capacity */
+template <typename T>
+struct generated_label;
+
+template <>
+struct generated_label<char> {
+    static constexpr std::size_t capacity = 90;
+
+    /* printable characters but the separators of the grammar */
+    static std::string text(std::size_t i){
+        static std::string const alphabet = []{
+            std::string a;
+            for(char c = '!'; c <= '~'; ++c){
+                if(c != '{' && c != '}' && c != ',' && c != '=') a.push_back(c);
+            }
+            return a;
+        }();
+        return std::string(1, alphabet[i]);
+    }
+};
+
+template <>
+struct generated_label<int> {
+    static constexpr std::size_t capacity = std::numeric_limits<int>::max();
+
+    static std::string text(std::size_t i){
+        return std::to_string(i);
+    }
+};
+
+template <>
+struct generated_label<double> {
+    static constexpr std::size_t capacity = std::numeric_limits<std::size_t>::max();
+
+    /* quarters print exactly */
+    static std::string text(std::size_t i){
+        std::ostringstream os;
+        os << static_cast<double>(i) / 4;
+        return os.str();
+    }
+};
+
+template <>
+struct generated_label<std::string> {
+    static constexpr std::size_t capacity = std::numeric_limits<std::size_t>::max();
+
+    /* bijective base 26: a, ..., z, aa, ab, ... */
+    static std::string text(std::size_t i){
+        std::string s;
+        ++i;
+        while(i > 0){
+            --i;
+            s.push_back(static_cast<char>('a' + i % 26));
+            i /= 26;
+        }
+        std::reverse(s.begin(), s.end());
+        return s;
+    }
+};
+
+// Constructors
+
+/** Prepares the Zipf law of the fan-out */
+template <typename T>
+trie_generator<T>::trie_generator(generator_options const& options)
+    : m_options(options), m_zipf(), m_gen(options.seed){
+    if(this->m_options.max_fanout == 0) this->m_options.max_fanout = 1;
+    if(this->m_options.max_depth < this->m_options.min_depth) this->m_options.max_depth = this->m_options.min_depth;
+    if(this->m_options.leaves == 0) this->m_options.leaves = 1;
+    double sum = 0;
+    for(std::size_t k = 1; k <= this->m_options.max_fanout; ++k){
+        sum += 1.0 / std::pow(static_cast<double>(k), this->m_options.zipf_s);
+        this->m_zipf.push_back(sum);
+    }
+    for(auto& p : this->m_zipf) p /= sum;
+}
+
+// Random numbers
+
+/** Uniform in [0, n) */
+template <typename T>
+std::uint64_t trie_generator<T>::below(std::uint64_t n){
+    return this->m_gen() % n;
+}
+
+/** Uniform in [0, 1) */
+template <typename T>
+double trie_generator<T>::unit(){
+    return static_cast<double>(this->m_gen() >> 11) * 0x1.0p-53;
+}
+
+/** Fan-out of an inner node from the Zipf law */
+template <typename T>
+std::size_t trie_generator<T>::fanout(){
+    auto it = std::upper_bound(this->m_zipf.begin(), this->m_zipf.end(), this->unit());
+    std::size_t k = static_cast<std::size_t>(it - this->m_zipf.begin()) + 1;
+    return std::min(k, this->m_options.max_fanout);
+}
+
+/**
+ * Splits the leaves of a node among its children, at least one each
+ * (exponential shares: every split is equally likely)
+*/
+template <typename T>
+std::vector<std::size_t> trie_generator<T>::split(std::size_t leaves, std::size_t fanout){
+    std::vector<double> shares(fanout);
+    double total = 0;
+    for(auto& s : shares){
+        s = -std::log(1.0 - this->unit());
+        total += s;
+    }
+    std::size_t rest = leaves - fanout;
+    std::size_t given = 0;
+    std::vector<std::size_t> parts(fanout);
+    for(std::size_t i = 0; i < fanout; ++i){
+        std::size_t extra = total > 0 ? static_cast<std::size_t>(rest * (shares[i] / total)) : 0;
+        extra = std::min(extra, rest - given);
+        parts[i] = 1 + extra;
+        given += extra;
+    }
+    // What the rounding left, one each from a random child
+    for(std::size_t i = this->below(fanout); given < rest; i = (i + 1) % fanout, ++given) ++parts[i];
+    return parts;
+}
+
+/** n distinct labels in increasing order of index, with random gaps */
+template <typename T>
+std::vector<std::string> trie_generator<T>::sibling_labels(std::size_t n){
+    std::size_t capacity = generated_label<T>::capacity;
+    std::size_t spare = capacity - n < 2 * n ? capacity - n : 2 * n;
+    std::size_t gap = std::min<std::size_t>(2, spare / n);
+    std::vector<std::string> labels;
+    labels.reserve(n);
+    std::size_t i = this->below(gap + 1);
+    for(std::size_t k = 0; k < n; ++k){
+        labels.push_back(generated_label<T>::text(i));
+        i += 1 + this->below(gap + 1);
+    }
+    return labels;
+}
+
+// Writing
+
+template <typename T>
+void trie_generator<T>::tabs(std::ostream& os, std::size_t level){
+    if(!this->m_options.indent) return;
+    for(std::size_t i = 0; i < level; ++i) os << "    ";
+}
+
+/** Writes the beginning of a node with children(no label for the root) */
+template <typename T>
+void trie_generator<T>::open(std::ostream& os, std::string const* label, std::size_t level){
+    this->tabs(os, level);
+    if(label) os << *label << " ";
+    os << "children = {\n";
+}
+
+template <typename T>
+void trie_generator<T>::close(std::ostream& os, std::size_t level){
+    os << "\n";
+    this->tabs(os, level);
+    os << "}";
+}
+
+template <typename T>
+void trie_generator<T>::leaf(std::ostream& os, std::string const* label, std::size_t level){
+    double w = this->m_options.min_weight + this->unit() * (this->m_options.max_weight - this->m_options.min_weight);
+    this->tabs(os, level);
+    if(label) os << *label << " ";
+    // Two decimals at any magnitude, the default precision would switch to an exponent
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(2) << std::round(w * 100) / 100 << " children = {}";
+    os.flags(flags);
+    os.precision(precision);
+}
+
+/**
+ * Writes a node: a leaf or a chain ending in a leaf are written at once,
+ * a node with more leaves is opened and pushed on the stack
+ * @param label its label, nullptr for the root
+ * @param leaves number of leaves below it
+ * @param depth its depth without chains
+ * @param level its depth for the indentation
+*/
+template <typename T>
+void trie_generator<T>::visit(std::ostream& os, std::string const* label, std::size_t leaves, std::size_t depth, std::size_t level, std::vector<frame>& stack){
+    std::size_t chain_label_count = std::min<std::size_t>(generated_label<T>::capacity, 26);
+    std::string chain_label;
+    if(leaves == 1){
+        std::size_t target = this->m_options.min_depth + this->below(this->m_options.max_depth - this->m_options.min_depth + 1);
+        std::size_t opened = 0;
+        for(; depth < target; ++depth, ++level, ++opened){
+            this->open(os, label, level);
+            chain_label = generated_label<T>::text(this->below(chain_label_count));
+            label = &chain_label;
+        }
+        this->leaf(os, label, level);
+        while(opened-- > 0) this->close(os, --level);
+        return;
+    }
+
+    std::size_t chain = 0;
+    if(depth > 0 && this->unit() < this->m_options.chain_probability){
+        for(; chain < this->m_options.chain_length; ++chain, ++level){
+            this->open(os, label, level);
+            chain_label = generated_label<T>::text(this->below(chain_label_count));
+            label = &chain_label;
+        }
+    }
+    std::size_t n;
+    if(depth + 1 >= this->m_options.max_depth){
+        // The last level takes all the leaves left
+        n = leaves;
+    }else if(this->unit() < this->m_options.wide_probability){
+        n = this->m_options.wide_fanout;
+    }else{
+        n = this->fanout();
+    }
+    n = std::max<std::size_t>(1, std::min({n, leaves, generated_label<T>::capacity}));
+
+    frame f{{}, 0, depth, level, chain};
+    std::vector<std::size_t> parts = this->split(leaves, n);
+    std::vector<std::string> labels = this->sibling_labels(n);
+    f.children.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) f.children.push_back(child{std::move(labels[i]), parts[i]});
+    this->open(os, label, level);
+    stack.push_back(std::move(f));
+}
+
+/**
+ * Writes the generated trie
+ * @param os the stream to write on
+ * @return written os
+*/
+template <typename T>
+std::ostream& trie_generator<T>::write(std::ostream& os){
+    this->m_gen.seed(this->m_options.seed);
+    std::vector<frame> stack;
+    this->visit(os, nullptr, this->m_options.leaves, 0, 0, stack);
+    while(!stack.empty()){
+        frame& top = stack.back();
+        if(top.next == top.children.size()){
+            std::size_t level = top.level;
+            std::size_t chain = top.chain;
+            stack.pop_back();
+            this->close(os, level);
+            while(chain-- > 0) this->close(os, --level);
+            continue;
+        }
+        if(top.next > 0) os << ",\n";
+        // Copy what is needed, visit() can push and move the frames
+        child c = std::move(top.children[top.next++]);
+        std::size_t depth = top.depth + 1;
+        std::size_t level = top.level + 1;
+        this->visit(os, &c.label, c.leaves, depth, level, stack);
+    }
+    os << "\n";
+    return os;
+}
+
+template <typename T>
+trie<T> generate_trie(generator_options const& options){
+    std::stringstream ss;
+    trie_generator<T>{options}.write(ss);
+    trie<T> t;
+    ss >> t;
+    return t;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef TRIE_HASH_CPP
+#define TRIE_HASH_CPP
+
+#include <cstring>
+#include <functional>
+
+#include "side_index.cpp"
+#include "trie_hash.hpp"
+
+// Hash functions
+
+/* finalizer of splitmix64 */
+inline std::uint64_t mix_hash(std::uint64_t x){
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* order dependent combination */
+inline std::uint64_t combine_hash(std::uint64_t h, std::uint64_t v){
+    return mix_hash(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+inline std::uint64_t leaf_hash(double w){
+    // 0.0 == -0.0 for operator==, they must hash the same
+    if(w == 0.0) w = 0.0;
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &w, sizeof(bits));
+    return mix_hash(bits ^ 0x6c65616620686173ULL);
+}
+
+/* hash of an inner node from the ones of its children */
+template <typename T, typename ChildHash>
+std::uint64_t inner_hash(trie<T> const& t, ChildHash child_hash){
+    std::uint64_t h = 0x696e6e6572206861ULL;
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        h = combine_hash(h, static_cast<std::uint64_t>(std::hash<T>{}(*(it->get_label()))));
+        h = combine_hash(h, child_hash(*it));
+    }
+    return h;
+}
+
+template <typename T>
+std::uint64_t hash_trie(trie<T> const& t){
+    if(t.get_children().empty()) return leaf_hash(t.get_weight());
+    return inner_hash(t, [](trie<T> const& c){ return hash_trie(c); });
+}
+
+template <typename T>
+std::size_t trie_hasher<T>::operator()(trie<T> const& t) const{
+    return static_cast<std::size_t>(hash_trie(t));
+}
+
+// Constructors
+
+/** Computes the hashes of every sub-trie of t */
+template <typename T>
+hash_index<T>::hash_index(trie<T>& t) : side_index<T, std::uint64_t, hash_index<T>>(t) {
+    this->build(t);
+}
+
+/**
+ * Computes the hashes of a sub-trie(post order)
+ * @return The hash of t
+*/
+template <typename T>
+std::uint64_t hash_index<T>::build(trie<T> const& t){
+    if(t.get_children().empty()) return leaf_hash(t.get_weight());
+    std::uint64_t h = inner_hash(t, [this](trie<T> const& c){ return this->build(c); });
+    this->m_entries[&t] = h;
+    return h;
+}
+
+/** Recomputes the hash of an internal node from its children */
+template <typename T>
+void hash_index<T>::update_entry(trie<T> const& t){
+    this->m_entries[&t] = inner_hash(t, [this](trie<T> const& c){ return this->hash(c); });
+}
+
+// Queries
+
+template <typename T>
+std::uint64_t hash_index<T>::hash() const{
+    return this->hash(*(this->m_t));
+}
+
+/** Returns the hash of a sub-trie of the indexed trie */
+template <typename T>
+std::uint64_t hash_index<T>::hash(trie<T> const& sub) const{
+    if(sub.get_children().empty()) return leaf_hash(sub.get_weight());
+    std::uint64_t const* h = this->find(sub);
+    if(!h) throw parser_exception{"The sub-trie is not indexed"};
+    return *h;
+}
+
+template <typename T>
+bool probably_equal(hash_index<T> const& a, hash_index<T> const& b){
+    return a.hash() == b.hash();
+}
+
+/**
+ * Compares two sub-tries as operator==, skipping the pairs whose hashes differ
+ * @return If they are equal
+*/
+template <typename T>
+bool equal_subtries(hash_index<T> const& a, trie<T> const& x, hash_index<T> const& b, trie<T> const& y){
+    if(a.hash(x) != b.hash(y)) return false;
+    if(&x == &y) return true;
+    if(x.get_children().empty() || y.get_children().empty()){
+        return x.get_children().empty() && y.get_children().empty() && x.get_weight() == y.get_weight();
+    }
+    auto i = x.get_children().begin();
+    auto j = y.get_children().begin();
+    for(; i != x.get_children().end() && j != y.get_children().end(); ++i, ++j){
+        if(!(*(i->get_label()) == *(j->get_label())) || !equal_subtries(a, *i, b, *j)) return false;
+    }
+    return i == x.get_children().end() && j == y.get_children().end();
+}
+
+template <typename T>
+bool equal(hash_index<T> const& a, hash_index<T> const& b){
+    return equal_subtries(a, a.get_trie(), b, b.get_trie());
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TRIE_INSTRUMENT_CPP
+#define TRIE_INSTRUMENT_CPP
+
+#include <string>
+
+#include "trie_instrument.hpp"
+
+// Operation stats
+
+inline void trie_op_stats::record(std::uint64_t ns, trie_counters const& delta){
+    ++(this->calls);
+    this->total_ns += ns;
+    this->counters.nodes_visited += delta.nodes_visited;
+    this->counters.label_comparisons += delta.label_comparisons;
+    this->counters.subtree_comparisons += delta.subtree_comparisons;
+    this->counters.allocations += delta.allocations;
+    std::size_t bucket = 0;
+    while(bucket + 1 < buckets && (ns >> (bucket + 1)) > 0) ++bucket;
+    ++(this->histogram[bucket]);
+}
+
+inline std::uint64_t trie_op_stats::percentile_ns(double q) const{
+    if(this->calls == 0) return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(this->calls - 1)) + 1;
+    std::uint64_t seen = 0;
+    for(std::size_t i = 0; i < buckets; ++i){
+        seen += this->histogram[i];
+        if(seen >= rank) return (std::uint64_t{1} << (i + 1)) - 1;
+    }
+    return (std::uint64_t{1} << buckets) - 1;
+}
+
+// Instruments
+
+inline trie_instrumentation& trie_instruments(){
+    thread_local trie_instrumentation instruments;
+    return instruments;
+}
+
+inline trie_op_stats const& trie_instrumentation::operator[](trie_op op) const{
+    return this->ops[static_cast<std::size_t>(op)];
+}
+
+/** Clears the stats of the operations(the running totals stay, open scopes use them) */
+inline void trie_instrumentation::reset(){
+    this->ops.fill(trie_op_stats{});
+}
+
+inline char const* trie_op_name(trie_op op){
+    static char const* const names[] = {"lookup", "leaf_next", "end", "max", "parse", "merge", "compress"};
+    return names[static_cast<std::size_t>(op)];
+}
+
+inline std::ostream& operator<<(std::ostream& os, trie_instrumentation const& instruments){
+    for(std::size_t i = 0; i < static_cast<std::size_t>(trie_op::count); ++i){
+        trie_op_stats const& s = instruments.ops[i];
+        if(s.calls == 0) continue;
+        std::string name = std::string{"trie_"} + trie_op_name(static_cast<trie_op>(i));
+        os << name << "_calls " << s.calls << "\n"
+            << name << "_total_ns " << s.total_ns << "\n"
+            << name << "_p50_ns " << s.percentile_ns(0.5) << "\n"
+            << name << "_p99_ns " << s.percentile_ns(0.99) << "\n"
+            << name << "_max_ns " << s.percentile_ns(1.0) << "\n"
+            << name << "_nodes_visited " << s.counters.nodes_visited << "\n"
+            << name << "_label_comparisons " << s.counters.label_comparisons << "\n"
+            << name << "_subtree_comparisons " << s.counters.subtree_comparisons << "\n"
+            << name << "_allocations " << s.counters.allocations << "\n";
+    }
+    return os;
+}
+
+// Timer
+
+inline trie_op_timer::trie_op_timer(trie_op op) : m_op(op), m_outer(false), m_start(), m_begin(){
+    trie_instrumentation& instruments = trie_instruments();
+    bool& running = instruments.running[static_cast<std::size_t>(op)];
+    if(running) return;
+    running = true;
+    this->m_outer = true;
+    this->m_start = instruments.counters;
+    this->m_begin = std::chrono::steady_clock::now();
+}
+
+inline trie_op_timer::~trie_op_timer(){
+    if(!this->m_outer) return;
+    auto elapsed = std::chrono::steady_clock::now() - this->m_begin;
+    trie_instrumentation& instruments = trie_instruments();
+    trie_counters delta;
+    delta.nodes_visited = instruments.counters.nodes_visited - this->m_start.nodes_visited;
+    delta.label_comparisons = instruments.counters.label_comparisons - this->m_start.label_comparisons;
+    delta.subtree_comparisons = instruments.counters.subtree_comparisons - this->m_start.subtree_comparisons;
+    delta.allocations = instruments.counters.allocations - this->m_start.allocations;
+    std::size_t i = static_cast<std::size_t>(this->m_op);
+    instruments.ops[i].record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), delta);
+    instruments.running[i] = false;
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef TRIE_MEMORY_CPP
+#define TRIE_MEMORY_CPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "trie_memory.hpp"
+
+// Footprint
+
+/* same layout as bag<trie<T>>::Node, which is private */
+template <typename T>
+struct bag_node_layout {
+    trie<T> val;
+    void* next;
+};
+
+/** Bytes a malloc-like allocator loses around a block of size bytes */
+inline std::size_t allocation_slack(std::size_t size){
+    std::size_t const word = sizeof(std::size_t);
+    std::size_t chunk = (size + word + 2 * word - 1) / (2 * word) * (2 * word);
+    if(chunk < 4 * word) chunk = 4 * word;
+    return chunk - size;
+}
+
+/** Heap bytes owned by a label, none by default */
+template <typename L>
+std::size_t label_owned_bytes(L const&){
+    return 0;
+}
+
+/** The buffer of a string, unless it is stored in the object */
+inline std::size_t label_owned_bytes(std::string const& s){
+    char const* begin = reinterpret_cast<char const*>(&s);
+    if(s.data() >= begin && s.data() < begin + sizeof(std::string)) return 0;
+    return s.capacity() + 1;
+}
+
+/**
+ * Walks a trie adding up its memory
+ * @param t the trie, its root counts as a node but not as a bag link
+ * @return The stats by category
+*/
+template <typename T>
+memory_stats memory_usage(trie<T> const& t){
+    memory_stats s;
+    std::size_t const link = sizeof(bag_node_layout<T>) - sizeof(trie<T>);
+    // Explicit stack, generated tries have long chains
+    std::vector<trie<T> const*> stack{&t};
+    while(!stack.empty()){
+        trie<T> const* n = stack.back();
+        stack.pop_back();
+        ++(s.nodes);
+        s.node_bytes += sizeof(trie<T>);
+        if(n != &t){
+            s.link_bytes += link;
+            s.slack_bytes += allocation_slack(sizeof(bag_node_layout<T>));
+        }
+        if(n->get_label()){
+            std::size_t owned = label_owned_bytes(*(n->get_label()));
+            ++(s.labels);
+            s.label_bytes += sizeof(T) + owned;
+            s.slack_bytes += allocation_slack(sizeof(T));
+            if(owned > 0) s.slack_bytes += allocation_slack(owned);
+        }
+        for(auto it = n->get_children().begin(); it != n->get_children().end(); ++it) stack.push_back(&(*it));
+    }
+    return s;
+}
+
+inline std::size_t memory_stats::total_bytes() const{
+    return this->node_bytes + this->link_bytes + this->label_bytes + this->slack_bytes;
+}
+
+inline double memory_stats::bytes_per_node() const{
+    return this->nodes ? static_cast<double>(this->total_bytes()) / this->nodes : 0.0;
+}
+
+inline std::ostream& operator<<(std::ostream& os, memory_stats const& s){
+    os << "trie_nodes " << s.nodes << "\n"
+        << "trie_labels " << s.labels << "\n"
+        << "trie_node_bytes " << s.node_bytes << "\n"
+        << "trie_link_bytes " << s.link_bytes << "\n"
+        << "trie_label_bytes " << s.label_bytes << "\n"
+        << "trie_slack_bytes " << s.slack_bytes << "\n"
+        << "trie_total_bytes " << s.total_bytes() << "\n"
+        << "trie_bytes_per_node " << s.bytes_per_node() << "\n";
+    return os;
+}
+
+// Allocation counters
+
+struct allocation_counters {
+    static inline std::atomic<std::size_t> allocations{0};
+    static inline std::atomic<std::size_t> deallocations{0};
+    static inline std::atomic<std::size_t> allocated_bytes{0};
+    static inline std::atomic<std::size_t> freed_bytes{0};
+    static inline std::atomic<std::size_t> peak_bytes{0};
+
+    static void allocated(std::size_t size){
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        std::size_t live = allocated_bytes.fetch_add(size, std::memory_order_relaxed) + size - freed_bytes.load(std::memory_order_relaxed);
+        std::size_t peak = peak_bytes.load(std::memory_order_relaxed);
+        while(live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    static void freed(std::size_t size){
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+        freed_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+};
+
+inline long long allocation_stats::live_bytes() const{
+    return static_cast<long long>(this->allocated_bytes) - static_cast<long long>(this->freed_bytes);
+}
+
+inline std::ostream& operator<<(std::ostream& os, allocation_stats const& s){
+    os << "trie_allocations " << s.allocations << "\n"
+        << "trie_deallocations " << s.deallocations << "\n"
+        << "trie_allocated_bytes " << s.allocated_bytes << "\n"
+        << "trie_freed_bytes " << s.freed_bytes << "\n"
+        << "trie_live_bytes " << s.live_bytes() << "\n"
+        << "trie_peak_bytes " << s.peak_bytes << "\n";
+    return os;
+}
+
+inline allocation_stats current_allocations(){
+    allocation_stats s;
+    s.allocations = allocation_counters::allocations.load(std::memory_order_relaxed);
+    s.deallocations = allocation_counters::deallocations.load(std::memory_order_relaxed);
+    s.allocated_bytes = allocation_counters::allocated_bytes.load(std::memory_order_relaxed);
+    s.freed_bytes = allocation_counters::freed_bytes.load(std::memory_order_relaxed);
+    s.peak_bytes = allocation_counters::peak_bytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+/** Starts counting, the peak restarts from the live bytes */
+inline allocation_scope::allocation_scope() : m_start(current_allocations()){
+    allocation_counters::peak_bytes.store(static_cast<std::size_t>(this->m_start.live_bytes()), std::memory_order_relaxed);
+}
+
+inline allocation_stats allocation_scope::stats() const{
+    allocation_stats now = current_allocations();
+    allocation_stats s;
+    s.allocations = now.allocations - this->m_start.allocations;
+    s.deallocations = now.deallocations - this->m_start.deallocations;
+    s.allocated_bytes = now.allocated_bytes - this->m_start.allocated_bytes;
+    s.freed_bytes = now.freed_bytes - this->m_start.freed_bytes;
+    long long start_live = this->m_start.live_bytes();
+    long long peak = static_cast<long long>(now.peak_bytes) - start_live;
+    s.peak_bytes = peak > 0 ? static_cast<std::size_t>(peak) : 0;
+    return s;
+}
+
+#ifdef TRIE_TRACK_ALLOCATIONS
+
+inline bool allocations_tracked(){
+    return true;
+}
+
+// Counting operator new/delete: the size is kept in a header before the block
+
+static constexpr std::size_t allocation_header = alignof(std::max_align_t);
+
+void* operator new(std::size_t size){
+    void* p = std::malloc(size + allocation_header);
+    if(!p) throw std::bad_alloc{};
+    *static_cast<std::size_t*>(p) = size;
+    allocation_counters::allocated(size);
+    return static_cast<char*>(p) + allocation_header;
+}
+
+// Not inlined, or g++ warns that free() gets a pointer from new
+__attribute__((noinline)) void operator delete(void* p) noexcept{
+    if(!p) return;
+    char* block = static_cast<char*>(p) - allocation_header;
+    allocation_counters::freed(*reinterpret_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept{
+    ::operator delete(p);
+}
+
+#else
+
+inline bool allocations_tracked(){
+    return false;
+}
+
+#endif
+
+#endif
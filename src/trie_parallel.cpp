@@ -0,0 +1,560 @@
+#ifndef TRIE_PARALLEL_CPP
+#define TRIE_PARALLEL_CPP
+
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include "trie_parallel.hpp"
+
+// Parallel loading
+
+/** Range of the text parsed by a single task, its children go under the split node */
+struct parse_job {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t split;
+};
+
+/** A node whose children list is split in more jobs */
+template <typename T>
+struct parse_split {
+    T label;
+    std::size_t parent;
+};
+
+/** Returns if c is a separator for the .tr format */
+inline bool is_blank(char c){
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * Finds the brace closing the one in position open
+ * @return The position of the closing brace, npos if it is missing
+*/
+inline std::size_t match_brace(std::string const& text, std::size_t open, std::size_t end){
+    std::size_t depth = 0;
+    for(std::size_t i = open; i < end; ++i){
+        if(text[i] == '{'){
+            ++depth;
+        }else if(text[i] == '}'){
+            if(--depth == 0) return i;
+        }
+    }
+    return std::string::npos;
+}
+
+/**
+ * Splits the body of a children list in its "x trie" items(commas at depth 0)
+ * @param items where the [begin, end) ranges of the items are written, blanks trimmed
+ * @return If the list is well formed(no empty item, balanced braces)
+*/
+inline bool split_items(std::string const& text, std::size_t begin, std::size_t end, std::vector<std::pair<std::size_t, std::size_t>>& items){
+    std::size_t depth = 0;
+    std::size_t start = begin;
+    for(std::size_t i = begin; i <= end; ++i){
+        if(i == end || (text[i] == ',' && depth == 0)){
+            std::size_t b = start;
+            std::size_t e = i;
+            while(b < e && is_blank(text[b])) ++b;
+            while(e > b && is_blank(text[e - 1])) --e;
+            if(b == e) return false;
+            items.push_back({b, e});
+            start = i + 1;
+        }else if(text[i] == '{'){
+            ++depth;
+        }else if(text[i] == '}'){
+            if(depth == 0) return false;
+            --depth;
+        }
+    }
+    return depth == 0;
+}
+
+/**
+ * Parses the header of an item "LABEL children = { BODY }"
+ * @param label where the label is written
+ * @param body_begin where the first position of the body is written
+ * @param body_end where the position of the closing brace is written
+ * @return If the item is an internal node with a not empty body(otherwise it isn't split)
+*/
+template <typename T>
+bool split_header(std::string const& text, std::size_t begin, std::size_t end, T& label, std::size_t& body_begin, std::size_t& body_end){
+    std::size_t open = text.find('{', begin);
+    if(open == std::string::npos || open >= end) return false;
+    if(match_brace(text, open, end) != end - 1) return false;
+    std::istringstream header{text.substr(begin, open - begin)};
+    header >> label;
+    if(header.fail()) return false;
+    std::string s = "";
+    header >> s;
+    if(s != "children") return false;
+    char c = 0;
+    header >> c;
+    if(c != '=') return false;
+    header >> c;
+    if(!header.fail()) return false;
+    body_begin = open + 1;
+    body_end = end - 1;
+    for(std::size_t i = body_begin; i < body_end; ++i){
+        if(!is_blank(text[i])) return true;
+    }
+    return false;
+}
+
+/**
+ * Plans the jobs for the children list [begin, end) of a split node.
+ * Items bigger than grain are split recursively up to split_depth levels,
+ * consecutive smaller items are grouped in jobs of about grain bytes.
+ * @return If the list is well formed
+*/
+template <typename T>
+bool plan_children(std::string const& text, std::size_t begin, std::size_t end, std::size_t split, unsigned depth, unsigned split_depth, std::size_t grain, std::vector<parse_split<T>>& splits, std::vector<parse_job>& jobs){
+    std::vector<std::pair<std::size_t, std::size_t>> items;
+    if(!split_items(text, begin, end, items)) return false;
+
+    std::size_t batch_begin = 0;
+    std::size_t batch_end = 0;
+    bool batch = false;
+    for(auto const& item : items){
+        T label;
+        std::size_t body_begin = 0;
+        std::size_t body_end = 0;
+        if(depth < split_depth && item.second - item.first > grain && split_header(text, item.first, item.second, label, body_begin, body_end)){
+            if(batch) jobs.push_back({batch_begin, batch_end, split});
+            batch = false;
+            splits.push_back({label, split});
+            if(!plan_children(text, body_begin, body_end, splits.size() - 1, depth + 1, split_depth, grain, splits, jobs)) return false;
+        }else{
+            if(!batch) batch_begin = item.first;
+            batch_end = item.second;
+            batch = true;
+            if(batch_end - batch_begin >= grain){
+                jobs.push_back({batch_begin, batch_end, split});
+                batch = false;
+            }
+        }
+    }
+    if(batch) jobs.push_back({batch_begin, batch_end, split});
+    return true;
+}
+
+/**
+ * Parses a job: a list "x1 trie1, x2 trie2, ..." with the sequential grammar
+ * @param part the trie whose children are the parsed items
+*/
+template <typename T>
+void parse_job_text(std::string const& text, parse_job const& job, trie<T>& part){
+    std::istringstream is{text.substr(job.begin, job.end - job.begin)};
+    node(is, part);
+    skip_blank_spaces(is);
+    if(is.peek() != EOF) throw parser_exception{"Expected keyword '}'"};
+}
+
+/**
+ * Parses the content of a .tr file using all the workers of the pool
+ * @param text the content of the file
+ * @param t the trie to be written
+ * @param pool the workers
+ * @param split_depth number of levels whose children lists can be split
+*/
+template <typename T>
+void parallel_parse(std::string const& text, trie<T>& t, thread_pool& pool, unsigned split_depth){
+    // Pre-scan of the root: anything unusual is left to the sequential parser, which
+    // reports the error exactly as operator>>
+    std::size_t open = text.find('{');
+    std::size_t close = std::string::npos;
+    std::size_t start = 0;
+    while(start < text.size() && is_blank(text[start])) ++start;
+    bool parallel = open != std::string::npos && start < text.size() && text[start] != '-' && !(text[start] >= '0' && text[start] <= '9');
+    if(parallel){
+        std::istringstream header{text.substr(0, open)};
+        std::string s = "";
+        char c = 0;
+        header >> s >> c;
+        close = match_brace(text, open, text.size());
+        parallel = s == "children" && c == '=' && !(header >> c) && close != std::string::npos;
+        for(std::size_t i = close + 1; parallel && i < text.size(); ++i){
+            if(!is_blank(text[i])) parallel = false;
+        }
+    }
+
+    std::vector<parse_split<T>> splits{{T{}, 0}};
+    std::vector<parse_job> jobs;
+    std::size_t grain = text.size() / (pool.size() * 8) + 1;
+    if(parallel){
+        parallel = plan_children(text, open + 1, close, 0, 0, split_depth, grain, splits, jobs);
+    }
+    if(!parallel){
+        std::istringstream is{text};
+        is >> t;
+        return;
+    }
+
+    // Parse every job in its own subtree
+    std::vector<trie<T>> parts(jobs.size());
+    std::vector<std::exception_ptr> errors(jobs.size());
+    task_group group{pool};
+    for(std::size_t i = 0; i < jobs.size(); ++i){
+        group.submit([&text, &jobs, &parts, &errors, i]{
+            try{
+                parse_job_text(text, jobs[i], parts[i]);
+            }catch(...){
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    group.wait();
+    // Report the first error in file order
+    for(auto const& e : errors){
+        if(e) std::rethrow_exception(e);
+    }
+
+    // Stitch: splits are in pre-order, so going backwards a node is complete before its parent
+    std::vector<trie<T>> nodes(splits.size());
+    std::vector<std::vector<std::size_t>> split_jobs(splits.size());
+    for(std::size_t i = 0; i < jobs.size(); ++i) split_jobs[jobs[i].split].push_back(i);
+    for(std::size_t i = splits.size(); i-- > 0; ){
+        // Pairwise merge of the ordered lists of the parts, O(n log k)
+        std::vector<std::size_t> const& own = split_jobs[i];
+        for(std::size_t step = 1; step < own.size(); step *= 2){
+            for(std::size_t j = 0; j + step < own.size(); j += 2 * step){
+                if(!parts[own[j]].get_children().merge_ordered(parts[own[j + step]].get_children(), nullptr)){
+                    throw parser_exception{"There is already a child with same label"};
+                }
+            }
+        }
+        // The split children of the node are already in place
+        if(!own.empty() && !nodes[i].get_children().merge_ordered(parts[own[0]].get_children(), &(nodes[i]))){
+            throw parser_exception{"There is already a child with same label"};
+        }
+        if(i > 0){
+            nodes[i].set_label(&(splits[i].label));
+            std::size_t parent = splits[i].parent;
+            if(!nodes[parent].get_children().add_ordered(std::move(nodes[i]), &(nodes[parent]))){
+                throw parser_exception{"There is already a child with same label"};
+            }
+        }
+    }
+    t = std::move(nodes[0]);
+}
+
+/**
+ * Reads the whole stream and parses it in parallel
+ * @param is the stream to read from
+ * @param t the trie to be written
+ * @param threads number of workers, 0 to use the hardware concurrency
+ * @param split_depth number of levels whose children lists can be split
+ * @return is read
+*/
+template <typename T>
+std::istream& parallel_load(std::istream& is, trie<T>& t, unsigned threads, unsigned split_depth){
+    std::string text{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+    thread_pool pool{threads};
+    parallel_parse(text, t, pool, split_depth);
+    return is;
+}
+
+// Parallel traversal
+
+/**
+ * Visits the leaves of the sibling subtrees [first, last).
+ * Every grain visited nodes the outermost frame with pending siblings is
+ * given to the group as a new task, so the biggest remaining part is split.
+ * @param body gives the task local state(local()), visits leaves(leaf()) and collects the state(flush())
+*/
+template <typename Node, typename Body>
+void visit_leaf_range(decltype(std::declval<Node&>().get_children().begin()) first, decltype(std::declval<Node&>().get_children().begin()) last, Body& body, task_group& group, std::size_t grain){
+    using iterator = decltype(std::declval<Node&>().get_children().begin());
+    auto local = body.local();
+    std::vector<std::pair<iterator, iterator>> stack{{first, last}};
+    std::size_t visited = 0;
+    while(!stack.empty()){
+        if(stack.back().first == stack.back().second){
+            stack.pop_back();
+            continue;
+        }
+        Node& n = *(stack.back().first);
+        ++(stack.back().first);
+        if(n.get_children().empty()){
+            body.leaf(local, n);
+        }else{
+            stack.push_back({n.get_children().begin(), n.get_children().end()});
+        }
+        if(++visited >= grain){
+            visited = 0;
+            for(auto& frame : stack){
+                if(frame.first != frame.second){
+                    iterator b = frame.first;
+                    iterator e = frame.second;
+                    frame.first = frame.second;
+                    group.submit([b, e, &body, &group, grain]{ visit_leaf_range<Node>(b, e, body, group, grain); });
+                    break;
+                }
+            }
+        }
+    }
+    body.flush(local);
+}
+
+/** Visits all the leaves of t with a task group on the pool and waits its tasks */
+template <typename Node, typename Body>
+void visit_leaves(Node& t, Body& body, thread_pool& pool, std::size_t grain){
+    if(t.get_children().empty()){
+        auto local = body.local();
+        body.leaf(local, t);
+        body.flush(local);
+        return;
+    }
+    auto b = t.get_children().begin();
+    auto e = t.get_children().end();
+    task_group group{pool};
+    group.submit([b, e, &body, &group, grain]{ visit_leaf_range<Node>(b, e, body, group, grain); });
+    group.wait();
+}
+
+/** Body calling a function on every leaf */
+template <typename Node, typename F>
+struct for_each_leaf_body {
+    struct state {};
+    F& f;
+
+    state local() { return {}; }
+    void leaf(state&, Node& n) { f(n); }
+    void flush(state&) {}
+};
+
+/** Body reducing the leaves, partial results are collected under a lock */
+template <typename T, typename R, typename Map, typename Reduce>
+struct reduce_leaf_body {
+    struct state {
+        R value;
+        bool empty;
+    };
+    Map& map;
+    Reduce& reduce;
+    std::mutex lock;
+    std::vector<R> partials;
+
+    state local() { return {R{}, true}; }
+    void leaf(state& s, trie<T> const& n){
+        if(s.empty){
+            s.value = map(n);
+            s.empty = false;
+        }else{
+            s.value = reduce(s.value, map(n));
+        }
+    }
+    void flush(state& s){
+        if(s.empty) return;
+        std::lock_guard<std::mutex> guard{lock};
+        partials.push_back(s.value);
+    }
+};
+
+/**
+ * Returns if the leaf a comes before the leaf b in lexicographic order
+ * (climbs both paths up to the first common ancestor)
+*/
+template <typename T>
+bool leaf_precedes(trie<T> const* a, trie<T> const* b){
+    std::vector<trie<T> const*> path_a;
+    std::vector<trie<T> const*> path_b;
+    for(trie<T> const* n = a; n; n = n->get_parent()) path_a.push_back(n);
+    for(trie<T> const* n = b; n; n = n->get_parent()) path_b.push_back(n);
+    auto it_a = path_a.rbegin();
+    auto it_b = path_b.rbegin();
+    while(it_a != path_a.rend() && it_b != path_b.rend() && *it_a == *it_b){
+        ++it_a;
+        ++it_b;
+    }
+    if(it_a == path_a.rend() || it_b == path_b.rend()) return false;
+    return *((*it_a)->get_label()) < *((*it_b)->get_label());
+}
+
+/** Body searching the max weight leaf, every task keeps its own candidate */
+template <typename Node>
+struct max_leaf_body {
+    struct state {
+        Node* max;
+    };
+    std::mutex lock;
+    Node* max = nullptr;
+
+    state local() { return {nullptr}; }
+    void leaf(state& s, Node& n){
+        // Inside a task leaves are visited in lexicographic order: strict > keeps the first one
+        if(!s.max || n.get_weight() > s.max->get_weight()) s.max = &n;
+    }
+    void flush(state& s){
+        if(!s.max) return;
+        std::lock_guard<std::mutex> guard{lock};
+        if(!max || s.max->get_weight() > max->get_weight()
+            || (s.max->get_weight() == max->get_weight() && leaf_precedes(s.max, max))){
+            max = s.max;
+        }
+    }
+};
+
+template <typename T, typename F>
+void parallel_for_each_leaf(trie<T>& t, F f, thread_pool& pool, std::size_t grain){
+    for_each_leaf_body<trie<T>, F> body{f};
+    visit_leaves(t, body, pool, grain);
+}
+
+template <typename T, typename F>
+void parallel_for_each_leaf(trie<T> const& t, F f, thread_pool& pool, std::size_t grain){
+    for_each_leaf_body<trie<T> const, F> body{f};
+    visit_leaves(t, body, pool, grain);
+}
+
+template <typename T, typename R, typename Map, typename Reduce>
+R parallel_reduce(trie<T> const& t, R init, Map map, Reduce reduce, thread_pool& pool, std::size_t grain){
+    reduce_leaf_body<T, R, Map, Reduce> body{map, reduce, {}, {}};
+    visit_leaves(t, body, pool, grain);
+    R result = init;
+    for(auto const& r : body.partials) result = reduce(result, r);
+    return result;
+}
+
+template <typename T>
+std::size_t parallel_leaf_count(trie<T> const& t, thread_pool& pool){
+    return parallel_reduce(t, std::size_t{0},
+        [](trie<T> const&){ return std::size_t{1}; },
+        [](std::size_t a, std::size_t b){ return a + b; }, pool);
+}
+
+template <typename T>
+double parallel_weight_sum(trie<T> const& t, thread_pool& pool){
+    return parallel_reduce(t, 0.0,
+        [](trie<T> const& n){ return n.get_weight(); },
+        [](double a, double b){ return a + b; }, pool);
+}
+
+template <typename T>
+trie<T>& parallel_max(trie<T>& t, thread_pool& pool){
+    max_leaf_body<trie<T>> body;
+    visit_leaves(t, body, pool, 4096);
+    return *(body.max);
+}
+
+template <typename T>
+trie<T> const& parallel_max(trie<T> const& t, thread_pool& pool){
+    max_leaf_body<trie<T> const> body;
+    visit_leaves(t, body, pool, 4096);
+    return *(body.max);
+}
+
+// Union of many tries
+
+/** Adds w to the weight of all the leaves of t */
+template <typename T>
+void add_to_leaves(trie<T>& t, double w){
+    std::vector<trie<T>*> stack{&t};
+    while(!stack.empty()){
+        trie<T>* n = stack.back();
+        stack.pop_back();
+        if(n->get_children().empty()){
+            n->set_weight(n->get_weight() + w);
+        }else{
+            for(auto it = n->get_children().begin(); it != n->get_children().end(); ++it) stack.push_back(&(*it));
+        }
+    }
+}
+
+/**
+ * dst += src, the cases are the same of operator+=
+ * @param group if not null, common children of the first split_depth levels are merged by its tasks
+*/
+template <typename T>
+void merge_nodes(trie<T>& dst, trie<T>& src, task_group* group, unsigned split_depth){
+    if(dst.get_children().empty() && src.get_children().empty()){ // Both are leaves
+        dst.set_weight(dst.get_weight() + src.get_weight());
+    }else if(src.get_children().empty()){ // The second operand is a leaf
+        add_to_leaves(dst, src.get_weight());
+    }else if(dst.get_children().empty()){ // The first operand is a leaf: take the children of src
+        double w = dst.get_weight();
+        dst.get_children() = std::move(src.get_children());
+        dst.get_children().update_parent(&dst);
+        add_to_leaves(dst, w);
+    }else{
+        // Children of src with a new label are relinked, the common ones merged
+        dst.get_children().merge_ordered(src.get_children(), &dst, [group, split_depth](trie<T>& a, trie<T>& b){
+            if(group && split_depth > 0){
+                group->submit([&a, &b, group, split_depth]{ merge_nodes(a, b, group, split_depth - 1); });
+            }else{
+                merge_nodes(a, b, static_cast<task_group*>(nullptr), 0);
+            }
+        });
+    }
+}
+
+template <typename T>
+trie<T>& merge_into(trie<T>& dst, trie<T>& src){
+    merge_nodes(dst, src, static_cast<task_group*>(nullptr), 0);
+    return dst;
+}
+
+template <typename T>
+trie<T>& merge_into(trie<T>& dst, trie<T>& src, thread_pool& pool, unsigned split_depth){
+    // dst is complete only when the tasks of the call are done
+    task_group group{pool};
+    merge_nodes(dst, src, &group, split_depth);
+    group.wait();
+    return dst;
+}
+
+/**
+ * Folds nodes[1..] into nodes[0] in order, same result of nodes[0] + nodes[1] + ...
+ * When all the nodes are internal the fold of every label is independent:
+ * the children of the other nodes with a new label are relinked into nodes[0],
+ * the ones with a common label form a group folded by its own task.
+ * Groups with leaves are folded in order, as operator+ isn't associative there.
+*/
+template <typename T>
+void merge_group(std::vector<trie<T>*> nodes, task_group& group, unsigned depth, unsigned split_depth){
+    bool internal = true;
+    for(auto n : nodes){
+        if(n->get_children().empty()) internal = false;
+    }
+    trie<T>& dst = *(nodes[0]);
+    if(!internal || depth >= split_depth){
+        for(std::size_t i = 1; i < nodes.size(); ++i) merge_nodes(dst, *(nodes[i]), static_cast<task_group*>(nullptr), 0);
+        return;
+    }
+    // Relinking keeps the tries in place, so the pointers of the groups stay valid
+    std::vector<std::vector<trie<T>*>> labels;
+    std::unordered_map<trie<T>*, std::size_t> label_of;
+    for(std::size_t i = 1; i < nodes.size(); ++i){
+        dst.get_children().merge_ordered(nodes[i]->get_children(), &dst, [&labels, &label_of](trie<T>& a, trie<T>& b){
+            auto g = label_of.find(&a);
+            if(g == label_of.end()){
+                g = label_of.insert({&a, labels.size()}).first;
+                labels.push_back({&a});
+            }
+            labels[g->second].push_back(&b);
+        });
+    }
+    for(auto& same : labels){
+        group.submit([same, &group, depth, split_depth]{ merge_group(same, group, depth + 1, split_depth); });
+    }
+}
+
+template <typename T>
+trie<T> merge_all(trie<T>* shards, std::size_t count, thread_pool& pool, unsigned split_depth){
+    if(count == 0) return trie<T>{};
+    std::vector<trie<T>*> nodes;
+    for(std::size_t i = 0; i < count; ++i) nodes.push_back(shards + i);
+    task_group group{pool};
+    group.submit([nodes, &group, split_depth]{ merge_group(nodes, group, 0, split_depth); });
+    group.wait();
+    return std::move(shards[0]);
+}
+
+template <typename T>
+trie<T> merge_all(std::vector<trie<T>>& shards, thread_pool& pool, unsigned split_depth){
+    return merge_all(shards.data(), shards.size(), pool, split_depth);
+}
+
+#endif
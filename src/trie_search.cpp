@@ -0,0 +1,339 @@
+#ifndef TRIE_SEARCH_CPP
+#define TRIE_SEARCH_CPP
+
+#include <algorithm>
+
+#include "trie_search.hpp"
+
+// Fuzzy search
+
+/* state of a fuzzy search, shared by the levels of the walk */
+template <typename T>
+struct fuzzy_walk {
+    std::vector<T> const& s;
+    std::size_t max_edits;
+    std::vector<std::vector<std::size_t>> rows;  // one row per depth, reused
+    std::vector<T> path;
+    std::vector<trie_match<T>> matches;
+};
+
+/**
+ * Orders the matches for top-k: max weight first, then smaller distance,
+ * then lexicographic order(leaves are found in lexicographic order, so the
+ * position breaks the last tie)
+*/
+template <typename T>
+bool fuzzy_better(trie_match<T> const& a, std::size_t pos_a, trie_match<T> const& b, std::size_t pos_b){
+    if(a.weight != b.weight) return a.weight > b.weight;
+    if(a.distance != b.distance) return a.distance < b.distance;
+    return pos_a < pos_b;
+}
+
+/**
+ * Visits the children of t, the row of t is at depth
+ * @param t the node reached
+ * @param depth length of the path to t
+ * @param w the walk
+*/
+template <typename T>
+void fuzzy_visit(trie<T> const& t, std::size_t depth, fuzzy_walk<T>& w){
+    std::size_t n = w.s.size();
+    if(t.get_children().empty()){
+        std::size_t distance = w.rows[depth][n];
+        if(distance <= w.max_edits) w.matches.push_back(trie_match<T>{&t, w.path, t.get_weight(), distance});
+        return;
+    }
+    if(w.rows.size() == depth + 1) w.rows.emplace_back(n + 1);
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        T const& label = *(it->get_label());
+        std::vector<std::size_t> const& prev = w.rows[depth];
+        std::vector<std::size_t>& row = w.rows[depth + 1];
+        row[0] = prev[0] + 1;
+        std::size_t lowest = row[0];
+        for(std::size_t j = 1; j <= n; ++j){
+            std::size_t substitution = prev[j - 1] + (w.s[j - 1] == label ? 0 : 1);
+            row[j] = std::min(std::min(prev[j] + 1, row[j - 1] + 1), substitution);
+            lowest = std::min(lowest, row[j]);
+        }
+        // Every extension of this prefix costs at least lowest
+        if(lowest > w.max_edits) continue;
+        w.path.push_back(label);
+        fuzzy_visit(*it, depth + 1, w);
+        w.path.pop_back();
+    }
+}
+
+template <typename T>
+std::vector<trie_match<T>> fuzzy_search(trie<T> const& t, std::vector<T> const& s, std::size_t max_edits, std::size_t top_k){
+    fuzzy_walk<T> w{s, max_edits, {}, {}, {}};
+    w.rows.emplace_back(s.size() + 1);
+    for(std::size_t j = 0; j <= s.size(); ++j) w.rows[0][j] = j;
+    fuzzy_visit(t, 0, w);
+    if(top_k == 0) return w.matches;
+    // Stable order by weight: keep the position of the lexicographic order
+    std::vector<std::size_t> order(w.matches.size());
+    for(std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto better = [&w](std::size_t a, std::size_t b){ return fuzzy_better(w.matches[a], a, w.matches[b], b); };
+    std::size_t k = std::min(top_k, order.size());
+    std::partial_sort(order.begin(), order.begin() + k, order.end(), better);
+    std::vector<trie_match<T>> best;
+    for(std::size_t i = 0; i < k; ++i) best.push_back(std::move(w.matches[order[i]]));
+    return best;
+}
+
+// Pattern search
+
+template <typename T>
+pattern_token<T> pattern_token<T>::exact(T const& value){
+    return pattern_token<T>{label, value};
+}
+
+template <typename T>
+pattern_token<T> pattern_token<T>::one(){
+    return pattern_token<T>{any_one, T{}};
+}
+
+template <typename T>
+pattern_token<T> pattern_token<T>::run(){
+    return pattern_token<T>{any_run, T{}};
+}
+
+/** Creates the end iterator */
+template <typename T>
+pattern_iterator<T>::pattern_iterator() : m_pattern(), m_stack(), m_path(), m_leaf(nullptr) {}
+
+/**
+ * Creates an iterator on the first leaf of t matching the pattern
+ * @param t the trie
+ * @param pattern the tokens to match
+*/
+template <typename T>
+pattern_iterator<T>::pattern_iterator(trie<T> const& t, std::vector<pattern_token<T>> const& pattern)
+    : m_pattern(pattern), m_stack(), m_path(), m_leaf(nullptr){
+    std::vector<std::size_t> states{0};
+    this->closure(states);
+    if(t.get_children().empty()){
+        // A leaf root is the empty sequence
+        if(this->accepts(states)) this->m_leaf = &t;
+        return;
+    }
+    this->m_stack.push_back(frame{t.get_children().begin(), t.get_children().end(), std::move(states)});
+    this->advance();
+}
+
+/** Adds the positions reachable skipping any run tokens(which match the empty run) */
+template <typename T>
+void pattern_iterator<T>::closure(std::vector<std::size_t>& states) const{
+    for(std::size_t i = 0; i < states.size(); ++i){
+        std::size_t p = states[i];
+        if(p < this->m_pattern.size() && this->m_pattern[p].kind == pattern_token<T>::any_run
+            && std::find(states.begin(), states.end(), p + 1) == states.end()){
+            states.push_back(p + 1);
+        }
+    }
+}
+
+/** Positions reached consuming a label from the given ones */
+template <typename T>
+std::vector<std::size_t> pattern_iterator<T>::step(std::vector<std::size_t> const& states, T const& l) const{
+    std::vector<std::size_t> next;
+    for(std::size_t p : states){
+        if(p == this->m_pattern.size()) continue;
+        pattern_token<T> const& token = this->m_pattern[p];
+        std::size_t reached = p + 1;
+        if(token.kind == pattern_token<T>::any_run){
+            reached = p;
+        }else if(token.kind == pattern_token<T>::label && !(token.value == l)){
+            continue;
+        }
+        if(std::find(next.begin(), next.end(), reached) == next.end()) next.push_back(reached);
+    }
+    this->closure(next);
+    return next;
+}
+
+/** If the whole pattern has been matched */
+template <typename T>
+bool pattern_iterator<T>::accepts(std::vector<std::size_t> const& states) const{
+    return std::find(states.begin(), states.end(), this->m_pattern.size()) != states.end();
+}
+
+/** Resumes the descent until the next matching leaf(or the end) */
+template <typename T>
+void pattern_iterator<T>::advance(){
+    this->m_leaf = nullptr;
+    while(!this->m_stack.empty()){
+        frame& top = this->m_stack.back();
+        if(top.it == top.end){
+            this->m_stack.pop_back();
+            if(!this->m_path.empty()) this->m_path.pop_back();
+            continue;
+        }
+        trie<T> const& child = *(top.it);
+        ++(top.it);
+        std::vector<std::size_t> states = this->step(top.states, *(child.get_label()));
+        // No position reached: no sequence below child can match
+        if(states.empty()) continue;
+        if(child.get_children().empty()){
+            if(this->accepts(states)){
+                this->m_leaf = &child;
+                return;
+            }
+            continue;
+        }
+        this->m_path.push_back(*(child.get_label()));
+        this->m_stack.push_back(frame{child.get_children().begin(), child.get_children().end(), std::move(states)});
+    }
+}
+
+template <typename T>
+typename pattern_iterator<T>::reference pattern_iterator<T>::operator*() const{
+    return *(this->get_leaf().get_label());
+}
+
+template <typename T>
+typename pattern_iterator<T>::pointer pattern_iterator<T>::operator->() const{
+    return this->get_leaf().get_label();
+}
+
+template <typename T>
+pattern_iterator<T>& pattern_iterator<T>::operator++(){
+    this->advance();
+    return *this;
+}
+
+template <typename T>
+pattern_iterator<T> pattern_iterator<T>::operator++(int){
+    pattern_iterator<T> old = *this;
+    this->advance();
+    return old;
+}
+
+template <typename T>
+bool pattern_iterator<T>::operator==(pattern_iterator const& rhs) const{
+    return this->m_leaf == rhs.m_leaf;
+}
+
+template <typename T>
+bool pattern_iterator<T>::operator!=(pattern_iterator const& rhs) const{
+    return !(*this == rhs);
+}
+
+/** Returns the leaf pointed */
+template <typename T>
+trie<T> const& pattern_iterator<T>::get_leaf() const{
+    if(!this->m_leaf) throw parser_exception{"No leaf pointed"};
+    return *(this->m_leaf);
+}
+
+/** Returns the sequence of the leaf pointed */
+template <typename T>
+std::vector<T> pattern_iterator<T>::sequence() const{
+    std::vector<T> s = this->m_path;
+    if(this->get_leaf().get_label()) s.push_back(*(this->m_leaf->get_label()));
+    return s;
+}
+
+template <typename T>
+pattern_iterator<T> pattern_range<T>::begin() const{
+    return pattern_iterator<T>{*(this->t), this->pattern};
+}
+
+template <typename T>
+pattern_iterator<T> pattern_range<T>::end() const{
+    return pattern_iterator<T>{};
+}
+
+template <typename T>
+pattern_range<T> pattern_search(trie<T> const& t, std::vector<pattern_token<T>> const& pattern){
+    return pattern_range<T>{&t, pattern};
+}
+
+inline std::vector<pattern_token<char>> make_pattern(std::string const& text){
+    std::vector<pattern_token<char>> pattern;
+    for(std::size_t i = 0; i < text.size(); ++i){
+        if(text[i] == '\\' && i + 1 < text.size()){
+            pattern.push_back(pattern_token<char>::exact(text[++i]));
+        }else if(text[i] == '?'){
+            pattern.push_back(pattern_token<char>::one());
+        }else if(text[i] == '*'){
+            // Consecutive runs match the same sequences as one
+            if(pattern.empty() || pattern.back().kind != pattern_token<char>::any_run) pattern.push_back(pattern_token<char>::run());
+        }else{
+            pattern.push_back(pattern_token<char>::exact(text[i]));
+        }
+    }
+    return pattern;
+}
+
+// Range queries
+
+/**
+ * Descends the path of s and returns the node whose first leaf is the bound
+ * @param t the trie(trie<T> or trie<T> const)
+ * @param s the sequence
+ * @param upper if the leaf of s itself is excluded
+ * @return The node, nullptr if every leaf is before the bound
+*/
+template <typename Node, typename T>
+Node* bound_node(Node* t, std::vector<T> const& s, bool upper){
+    // Deepest sibling after the path: its first leaf follows every leaf below the path
+    Node* next = nullptr;
+    Node* reached = t;
+    for(std::size_t i = 0; i < s.size(); ++i){
+        if(reached->get_children().empty()){
+            // The leaf is a proper prefix of s, so it is before s
+            return next;
+        }
+        Node* equal = nullptr;
+        for(auto it = reached->get_children().begin(); it != reached->get_children().end(); ++it){
+            if(s[i] < *(it->get_label())){
+                // The children are sorted: this is the first one after s[i]
+                next = &(*it);
+                break;
+            }
+            if(!(*(it->get_label()) < s[i])) equal = &(*it);
+        }
+        if(!equal) return next;
+        reached = equal;
+    }
+    // reached is the node of s: its leaves are s itself or extensions of s
+    if(upper && reached->get_children().empty()) return next;
+    return reached;
+}
+
+template <typename T>
+typename trie<T>::leaf_iterator lower_bound(trie<T>& t, std::vector<T> const& s){
+    trie<T>* n = bound_node(&t, s, false);
+    return n ? typename trie<T>::leaf_iterator{n} : t.end();
+}
+
+template <typename T>
+typename trie<T>::const_leaf_iterator lower_bound(trie<T> const& t, std::vector<T> const& s){
+    trie<T> const* n = bound_node(&t, s, false);
+    return n ? typename trie<T>::const_leaf_iterator{n} : t.end();
+}
+
+template <typename T>
+typename trie<T>::leaf_iterator upper_bound(trie<T>& t, std::vector<T> const& s){
+    trie<T>* n = bound_node(&t, s, true);
+    return n ? typename trie<T>::leaf_iterator{n} : t.end();
+}
+
+template <typename T>
+typename trie<T>::const_leaf_iterator upper_bound(trie<T> const& t, std::vector<T> const& s){
+    trie<T> const* n = bound_node(&t, s, true);
+    return n ? typename trie<T>::const_leaf_iterator{n} : t.end();
+}
+
+template <typename T>
+std::pair<typename trie<T>::leaf_iterator, typename trie<T>::leaf_iterator> range(trie<T>& t, std::vector<T> const& lo, std::vector<T> const& hi){
+    return {lower_bound(t, lo), lower_bound(t, hi)};
+}
+
+template <typename T>
+std::pair<typename trie<T>::const_leaf_iterator, typename trie<T>::const_leaf_iterator> range(trie<T> const& t, std::vector<T> const& lo, std::vector<T> const& hi){
+    return {lower_bound(t, lo), lower_bound(t, hi)};
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef TRIE_STATS_CPP
+#define TRIE_STATS_CPP
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+#include "trie_memory.cpp"
+#include "trie_stats.hpp"
+
+// Collection
+
+/**
+ * Walks a trie once(explicit stack, chains can be long)
+ * @param t the trie, it is the depth 0
+ * @return The stats of its shape
+*/
+template <typename T>
+trie_stats collect_stats(trie<T> const& t){
+    struct visit {
+        trie<T> const* node;
+        std::size_t depth;
+        std::size_t run;  // single-child nodes right above it
+    };
+    trie_stats s;
+    // One bytes-per-node model for both reports: the one of memory_usage
+    s.node_bytes = static_cast<std::size_t>(std::lround(memory_usage(t).bytes_per_node()));
+    std::ostringstream label;
+    std::vector<visit> stack{{&t, 0, 0}};
+    while(!stack.empty()){
+        visit v = stack.back();
+        stack.pop_back();
+        ++(s.nodes);
+        if(v.depth >= s.nodes_by_depth.size()){
+            s.nodes_by_depth.resize(v.depth + 1, 0);
+            s.leaves_by_depth.resize(v.depth + 1, 0);
+        }
+        ++(s.nodes_by_depth[v.depth]);
+        if(v.depth > s.max_depth) s.max_depth = v.depth;
+        if(v.node->get_label()){
+            label.str("");
+            label << *(v.node->get_label());
+            ++(s.label_sizes[label.str().size()]);
+        }
+
+        bag<trie<T>> const& children = v.node->get_children();
+        if(children.empty()){
+            ++(s.leaves);
+            ++(s.leaves_by_depth[v.depth]);
+            if(v.run > 0) ++(s.chains[v.run]);
+            continue;
+        }
+        if(v.node != &t && children.has_one_child()){
+            // The chain goes on in the child
+            ++(s.fanout[1]);
+            stack.push_back({&(*children.begin()), v.depth + 1, v.run + 1});
+            continue;
+        }
+        if(v.run > 0) ++(s.chains[v.run]);
+        std::size_t n = 0;
+        for(auto it = children.begin(); it != children.end(); ++it, ++n) stack.push_back({&(*it), v.depth + 1, 0});
+        ++(s.fanout[n]);
+    }
+    return s;
+}
+
+// Derived numbers
+
+inline std::size_t trie_stats::inner() const{
+    return this->nodes - this->leaves;
+}
+
+inline double trie_stats::mean_leaf_depth() const{
+    if(this->leaves == 0) return 0.0;
+    double sum = 0;
+    for(std::size_t d = 0; d < this->leaves_by_depth.size(); ++d) sum += static_cast<double>(d) * this->leaves_by_depth[d];
+    return sum / this->leaves;
+}
+
+/** Mean children of the inner nodes */
+inline double trie_stats::mean_fanout() const{
+    // Every node but the root is the child of an inner node
+    return this->inner() ? static_cast<double>(this->nodes - 1) / this->inner() : 0.0;
+}
+
+inline std::size_t trie_stats::compressible() const{
+    std::size_t n = 0;
+    for(auto const& c : this->chains) n += c.first * c.second;
+    return n;
+}
+
+// Report
+
+inline std::vector<std::string> recommendations(trie_stats const& s){
+    std::vector<std::string> advice;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1);
+    std::size_t removed = s.compressible();
+    if(removed > 0){
+        line << "path_compress would remove " << removed << " of " << s.nodes << " nodes("
+            << 100.0 * removed / s.nodes << "%), about " << removed * s.node_bytes << " bytes";
+        if(removed * 10 >= s.nodes) line << ": worth running";
+        advice.push_back(line.str());
+        line.str("");
+    }else{
+        advice.push_back("no single-child chains, path_compress would change nothing");
+    }
+    if(!s.chains.empty() && s.chains.rbegin()->first >= 8){
+        line << "longest chain has " << s.chains.rbegin()->first
+            << " nodes, operator[] and the leaf iterators walk it one node at a time";
+        advice.push_back(line.str());
+        line.str("");
+    }
+    if(!s.fanout.empty() && s.fanout.rbegin()->first > 64){
+        std::size_t wide = 0;
+        for(auto it = s.fanout.upper_bound(64); it != s.fanout.end(); ++it) wide += it->second;
+        line << wide << " nodes have more than 64 children(max " << s.fanout.rbegin()->first
+            << "), children are scanned linearly: an indexed or sorted-array layout would help";
+        advice.push_back(line.str());
+        line.str("");
+    }
+    if(s.inner() > 0 && s.mean_fanout() < 2.0){
+        line << "mean fan-out is " << s.mean_fanout() << ", most of the memory goes in bag links and labels"
+            << " of thin paths: a compact(array) layout would fit";
+        advice.push_back(line.str());
+        line.str("");
+    }
+    return advice;
+}
+
+inline std::ostream& operator<<(std::ostream& os, trie_stats const& s){
+    os << std::fixed << std::setprecision(2);
+    os << "nodes " << s.nodes << "\n"
+        << "leaves " << s.leaves << "\n"
+        << "inner " << s.inner() << "\n"
+        << "max_depth " << s.max_depth << "\n"
+        << "mean_leaf_depth " << s.mean_leaf_depth() << "\n"
+        << "mean_fanout " << s.mean_fanout() << "\n"
+        << "compressible " << s.compressible() << "\n";
+    os << "depth(nodes leaves)\n";
+    for(std::size_t d = 0; d < s.nodes_by_depth.size(); ++d){
+        os << "  " << d << " " << s.nodes_by_depth[d] << " " << s.leaves_by_depth[d] << "\n";
+    }
+    os << "fanout(children nodes)\n";
+    for(auto const& f : s.fanout) os << "  " << f.first << " " << f.second << "\n";
+    os << "chains(length chains)\n";
+    for(auto const& c : s.chains) os << "  " << c.first << " " << c.second << "\n";
+    os << "label_sizes(characters labels)\n";
+    for(auto const& l : s.label_sizes) os << "  " << l.first << " " << l.second << "\n";
+    os << std::defaultfloat;
+    os << "recommendations\n";
+    for(auto const& r : recommendations(s)) os << "  " << r << "\n";
+    return os;
+}
+
+#endif
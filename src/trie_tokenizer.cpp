@@ -0,0 +1,113 @@
+#ifndef TRIE_TOKENIZER_CPP
+#define TRIE_TOKENIZER_CPP
+
+#include <iterator>
+
+#include "flat_trie.cpp"
+#include "trie_tokenizer.hpp"
+
+// Constructors
+
+/** Empty dictionary: the root alone, every input is one unknown token */
+template <typename T>
+trie_tokenizer<T>::trie_tokenizer() : m_trie() {}
+
+template <typename T>
+trie_tokenizer<T>::trie_tokenizer(trie<T> const& dictionary) : m_trie(dictionary) {}
+
+// Walk
+
+/**
+ * Longest entry starting at first. Entries are leaves and nothing goes on
+ * below a leaf, so it is the leaf where the walk stops, if any.
+ * @param weight where the weight of its leaf is written
+ * @return Its length, 0 if no entry starts there
+*/
+template <typename T>
+template <typename Iterator>
+std::size_t trie_tokenizer<T>::longest_entry(Iterator first, Iterator last, double& weight) const{
+    std::size_t depth = 0;
+    index_type reached = 0;
+    for(; first != last; ++first){
+        reached = this->m_trie.child(reached, *first);
+        if(reached == flat_trie<T>::no_node) return 0;
+        ++depth;
+        if(this->m_trie.is_leaf(reached)){
+            weight = this->m_trie.get_weight(reached);
+            return depth;
+        }
+    }
+    return 0;
+}
+
+// Tokenization
+
+template <typename T>
+template <typename Iterator>
+std::size_t trie_tokenizer<T>::tokenize(Iterator first, Iterator last, std::vector<trie_token>& out) const{
+    std::size_t count = 0;
+    std::size_t offset = 0;
+    bool unknown = false;  // the last token is unknown and can grow
+    while(first != last){
+        double weight = 0.0;
+        std::size_t length = this->longest_entry(first, last, weight);
+        if(length == 0){
+            if(unknown){
+                ++(out.back().length);
+            }else{
+                out.push_back(trie_token{offset, 1, 0.0, false});
+                unknown = true;
+                ++count;
+            }
+            length = 1;
+        }else{
+            out.push_back(trie_token{offset, length, weight, true});
+            unknown = false;
+            ++count;
+        }
+        std::advance(first, length);
+        offset += length;
+    }
+    return count;
+}
+
+template <typename T>
+template <typename Sequence>
+std::size_t trie_tokenizer<T>::tokenize(Sequence const& input, std::vector<trie_token>& out) const{
+    return this->tokenize(std::begin(input), std::end(input), out);
+}
+
+template <typename T>
+template <typename Sequence>
+std::vector<std::vector<trie_token>> trie_tokenizer<T>::tokenize_batch(std::vector<Sequence> const& documents, thread_pool& pool, std::size_t grain) const{
+    std::vector<std::vector<trie_token>> tokens(documents.size());
+    task_group group{pool};
+    std::size_t begin = 0;
+    while(begin < documents.size()){
+        // Every task writes only the vectors of its documents
+        std::size_t end = begin;
+        std::size_t labels = 0;
+        while(end < documents.size() && (end == begin || labels < grain)){
+            labels += static_cast<std::size_t>(std::distance(std::begin(documents[end]), std::end(documents[end])));
+            ++end;
+        }
+        group.submit([this, &documents, &tokens, begin, end](){
+            for(std::size_t i = begin; i < end; ++i) this->tokenize(documents[i], tokens[i]);
+        });
+        begin = end;
+    }
+    group.wait();
+    return tokens;
+}
+
+template <typename T>
+std::size_t trie_tokenizer<T>::nodes() const{
+    return this->m_trie.nodes();
+}
+
+template <typename T>
+std::size_t trie_tokenizer<T>::bytes() const{
+    return this->m_trie.bytes();
+}
+
+#endif
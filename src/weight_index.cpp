@@ -0,0 +1,129 @@
+#ifndef WEIGHT_INDEX_CPP
+#define WEIGHT_INDEX_CPP
+
+#include <algorithm>
+#include <random>
+
+#include "side_index.cpp"
+#include "weight_index.hpp"
+
+// Constructors
+
+/** Indexes every sub-trie of t */
+template <typename T>
+weight_index<T>::weight_index(trie<T>& t) : side_index<T, weight_index_entry<T>, weight_index<T>>(t) {
+    this->build(t);
+}
+
+/**
+ * Indexes a sub-trie(post order)
+ * @return The sum of its leaves
+*/
+template <typename T>
+double weight_index<T>::build(trie<T> const& t){
+    if(t.get_children().empty()){
+        if(t.get_weight() < 0) throw parser_exception{"Negative weight"};
+        return t.get_weight();
+    }
+    weight_index_entry<T> e;
+    double sum = 0;
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        sum += this->build(*it);
+        e.children.push_back(&(*it));
+        e.prefix.push_back(sum);
+    }
+    this->m_entries[&t] = std::move(e);
+    return sum;
+}
+
+/** Recomputes the entry of an internal node from the sums of its children */
+template <typename T>
+void weight_index<T>::update_entry(trie<T> const& t){
+    weight_index_entry<T>& e = this->m_entries[&t];
+    e.children.clear();
+    e.prefix.clear();
+    double sum = 0;
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        sum += this->sum(*it);
+        e.children.push_back(&(*it));
+        e.prefix.push_back(sum);
+    }
+}
+
+// Sums
+
+/** Returns the sum of the weights of the leaves of sub */
+template <typename T>
+double weight_index<T>::sum(trie<T> const& sub) const{
+    if(sub.get_children().empty()) return sub.get_weight();
+    weight_index_entry<T> const* e = this->find(sub);
+    if(!e) throw parser_exception{"The sub-trie is not indexed"};
+    return e->prefix.back();
+}
+
+// Sampling
+
+template <typename T>
+template <typename Rng>
+trie<T> const& weight_index<T>::sample(Rng& rng) const{
+    return this->sample(*(this->m_t), rng);
+}
+
+/**
+ * Draws a leaf of sub with probability weight / sum(sub)
+ * @param sub a sub-trie of the indexed trie
+ * @param rng the random generator
+ * @return The leaf drawn
+*/
+template <typename T>
+template <typename Rng>
+trie<T> const& weight_index<T>::sample(trie<T> const& sub, Rng& rng) const{
+    trie<T> const* reached = &sub;
+    while(!reached->get_children().empty()){
+        weight_index_entry<T> const* found = this->find(*reached);
+        if(!found) throw parser_exception{"The sub-trie is not indexed"};
+        weight_index_entry<T> const& e = *found;
+        double sum = e.prefix.back();
+        if(!(sum > 0)) throw parser_exception{"No leaf with positive weight"};
+        double r = std::uniform_real_distribution<double>{0.0, sum}(rng);
+        std::size_t i = std::upper_bound(e.prefix.begin(), e.prefix.end(), r) - e.prefix.begin();
+        if(i == e.prefix.size()){
+            // r rounded up to sum: take the last child with positive weight
+            i = std::lower_bound(e.prefix.begin(), e.prefix.end(), sum) - e.prefix.begin();
+        }
+        reached = e.children[i];
+    }
+    return *reached;
+}
+
+template <typename T>
+template <typename Rng>
+std::vector<trie<T> const*> weight_index<T>::sample_n(Rng& rng, std::size_t n) const{
+    return this->sample_n(*(this->m_t), rng, n);
+}
+
+/** Draws n leaves of sub(with replacement) */
+template <typename T>
+template <typename Rng>
+std::vector<trie<T> const*> weight_index<T>::sample_n(trie<T> const& sub, Rng& rng, std::size_t n) const{
+    std::vector<trie<T> const*> drawn;
+    drawn.reserve(n);
+    for(std::size_t i = 0; i < n; ++i) drawn.push_back(&(this->sample(sub, rng)));
+    return drawn;
+}
+
+// Updates
+
+/**
+ * Changes the weight of a leaf and the sums of its ancestors(O(depth * fan-out))
+ * @param leaf a leaf of the indexed trie
+ * @param w the new weight
+*/
+template <typename T>
+void weight_index<T>::set_weight(trie<T>& leaf, double w){
+    if(w < 0) throw parser_exception{"Negative weight"};
+    leaf.set_weight(w);
+    this->update_path(leaf);
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "../src/trie.cpp"
+#include "../src/trie_generator.cpp"
+#define TRIE_TRACK_ALLOCATIONS
+#include "../src/trie_memory.cpp"
+#include "../src/dawg.cpp"
+#include "../src/aho_corasick.cpp"
+#include "../src/leaf_cursor.cpp"
+
+/*
+ * Benchmark suite of trie<T>: every case runs for at least min_time,
+ * doubling the iterations, and reports ns/op and bytes allocated per op
+ * (counted by the TRIE_TRACK_ALLOCATIONS hook of trie_memory); the
+ * footprint of the trie comes first and the peak RSS is printed at the end.
+ * The tries come from trie_generator(leaves, max fan-out, max depth).
+ * usage: bench [leaves] [fan-out] [depth] [filter] [min_time_ms]
+ * Only the cases whose name contains filter are run.
+ */
+
+// Harness
+
+/* state of a case: only the time between resume() and pause() is measured */
+struct bench_state {
+    std::size_t iterations;
+
+    void resume(){
+        allocation_stats now = current_allocations();
+        this->m_bytes_start = now.allocated_bytes;
+        this->m_allocs_start = now.allocations;
+        this->m_start = std::chrono::steady_clock::now();
+    }
+
+    void pause(){
+        this->m_elapsed += std::chrono::steady_clock::now() - this->m_start;
+        allocation_stats now = current_allocations();
+        this->m_bytes += now.allocated_bytes - this->m_bytes_start;
+        this->m_allocs += now.allocations - this->m_allocs_start;
+    }
+
+    std::chrono::duration<double, std::nano> m_elapsed{0};
+    std::size_t m_bytes = 0;
+    std::size_t m_allocs = 0;
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+    std::size_t m_bytes_start = 0;
+    std::size_t m_allocs_start = 0;
+};
+
+/**
+ * Makes the value observable: the compiler has to compute it, so the loop
+ * that produces it can't be dropped(an empty asm reading it from a register
+ * or memory, as benchmark libraries do)
+*/
+template <typename V>
+void do_not_optimize(V const& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct bench_case {
+    std::string name;
+    std::function<void(bench_state&)> body;
+};
+
+void run_case(bench_case const& c, std::chrono::milliseconds min_time){
+    for(std::size_t n = 1; ; n *= 2){
+        bench_state st;
+        st.iterations = n;
+        auto start = std::chrono::steady_clock::now();
+        c.body(st);
+        // Untimed setup can dominate(e.g. the copy before a move): bound the wall time too
+        bool slow_setup = std::chrono::steady_clock::now() - start >= 10 * min_time;
+        if(st.m_elapsed >= min_time || slow_setup || n >= (std::size_t{1} << 30)){
+            std::cout << std::left << std::setw(24) << c.name << std::right
+                << std::setw(12) << n
+                << std::setw(16) << std::fixed << std::setprecision(1) << st.m_elapsed.count() / n
+                << std::setw(16) << static_cast<double>(st.m_bytes) / n
+                << std::setw(14) << static_cast<double>(st.m_allocs) / n << "\n";
+            return;
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    std::size_t leaves = argc > 1 ? std::stoul(argv[1]) : 2000;
+    std::size_t fanout = argc > 2 ? std::stoul(argv[2]) : 8;
+    std::size_t depth = argc > 3 ? std::stoul(argv[3]) : 6;
+    std::string filter = argc > 4 ? argv[4] : "";
+    std::chrono::milliseconds min_time{argc > 5 ? std::stoul(argv[5]) : 200};
+
+    generator_options options;
+    options.leaves = leaves;
+    options.max_fanout = fanout;
+    options.max_depth = depth;
+    trie<std::string> t = generate_trie<std::string>(options);
+    options.seed += 1;
+    trie<std::string> other = generate_trie<std::string>(options);
+    std::vector<std::vector<std::string>> sequences;
+    leaf_cursor<std::string> cursor{t};
+    while(cursor.next()) sequences.push_back(cursor.sequence().to_vector());
+    std::ostringstream printed;
+    printed << t;
+    std::string text = printed.str();
+    dawg<std::string> graph = minimize(t);
+    aho_corasick<std::string> automaton{t};
+    std::vector<std::string> stream;
+    for(auto const& s : sequences) stream.insert(stream.end(), s.begin(), s.end());
+
+    std::vector<bench_case> cases{
+        {"parse", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                std::istringstream is{text};
+                trie<std::string> parsed;
+                st.resume();
+                is >> parsed;
+                do_not_optimize(parsed);
+                st.pause();
+            }
+        }},
+        {"print", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                std::ostringstream os;
+                st.resume();
+                os << t;
+                do_not_optimize(os);
+                st.pause();
+            }
+        }},
+        {"lookup", [&](bench_state& st){
+            double sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i) sink += t[sequences[i % sequences.size()]].get_weight();
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"max", [&](bench_state& st){
+            double sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i) sink += t.max().get_weight();
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"leaf_iteration", [&](bench_state& st){
+            std::size_t sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                for(auto it = t.begin(); it != t.end(); ++it) ++sink;
+            }
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"leaf_cursor", [&](bench_state& st){
+            std::size_t sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                leaf_cursor<std::string> c{t};
+                while(c.next()) sink += c.sequence().size;
+            }
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"union", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                st.resume();
+                trie<std::string> sum = t + other;
+                do_not_optimize(sum);
+                st.pause();
+            }
+        }},
+        {"path_compress", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                trie<std::string> copy{t};
+                st.resume();
+                copy.path_compress();
+                do_not_optimize(copy);
+                st.pause();
+            }
+        }},
+        {"copy", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                st.resume();
+                trie<std::string> copy{t};
+                do_not_optimize(copy);
+                st.pause();
+            }
+        }},
+        {"move", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                trie<std::string> source{t};
+                st.resume();
+                trie<std::string> moved{std::move(source)};
+                do_not_optimize(moved);
+                st.pause();
+            }
+        }},
+        {"minimize", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                st.resume();
+                dawg<std::string> d = minimize(t);
+                do_not_optimize(d);
+                st.pause();
+            }
+        }},
+        {"dawg_lookup", [&](bench_state& st){
+            double sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i) sink += graph[sequences[i % sequences.size()]].get_weight();
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"aho_corasick_scan", [&](bench_state& st){
+            std::size_t sink = 0;
+            st.resume();
+            for(std::size_t i = 0; i < st.iterations; ++i) sink += automaton.scan(stream, [](text_match const&){});
+            st.pause();
+            do_not_optimize(sink);
+        }},
+        {"destruction", [&](bench_state& st){
+            for(std::size_t i = 0; i < st.iterations; ++i){
+                auto copy = new trie<std::string>{t};
+                st.resume();
+                delete copy;
+                st.pause();
+            }
+        }},
+    };
+
+    std::cout << "leaves " << leaves << ", fan-out " << fanout << ", depth " << depth << "\n";
+    memory_stats memory = memory_usage(t);
+    std::cout << memory.nodes << " nodes, " << memory.total_bytes() << " bytes(" << memory.bytes_per_node() << " per node)\n";
+    std::cout << "minimized: " << graph.states() << " states, " << graph.edges() << " edges, " << graph.bytes() << " bytes\n";
+    std::cout << std::left << std::setw(24) << "case" << std::right << std::setw(12) << "iterations"
+        << std::setw(16) << "ns/op" << std::setw(16) << "bytes/op" << std::setw(14) << "allocs/op" << "\n";
+    for(auto const& c : cases){
+        if(c.name.find(filter) != std::string::npos) run_case(c, min_time);
+    }
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "peak RSS " << usage.ru_maxrss << " KiB\n";
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/trie.cpp"
+#include "../src/concurrent_trie.cpp"
+
+/*
+ * Read throughput of concurrent_trie against a trie behind a global mutex,
+ * with 1..max threads of readers(operator[], and max() of the subtree of a
+ * two labels prefix) and one writer inserting a sequence every writer_pause
+ * microseconds.
+ * usage: bench_concurrent [max_threads] [milliseconds] [writer_pause]
+ */
+
+std::vector<char> random_sequence(std::mt19937& gen, unsigned length){
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::vector<char> s;
+    for(unsigned i = 0; i < length; ++i) s.push_back(static_cast<char>(letter(gen)));
+    return s;
+}
+
+std::vector<char> prefix(std::vector<char> const& s){
+    return std::vector<char>{s.begin(), s.begin() + 2};
+}
+
+struct locked_trie {
+    trie<char> t;
+    std::mutex lock;
+};
+
+template <typename Read, typename Write>
+double run(unsigned readers, unsigned ms, unsigned writer_pause, std::vector<std::vector<char>> const& keys, Read read, Write write){
+    std::atomic<bool> stop{false};
+    std::atomic<unsigned long> reads{0};
+    std::vector<std::thread> threads;
+    for(unsigned r = 0; r < readers; ++r){
+        threads.emplace_back([&, r]{
+            unsigned long done = 0;
+            std::size_t i = r;
+            double sink = 0;
+            while(!stop.load(std::memory_order_relaxed)){
+                sink += read(keys[i % keys.size()], done % 16 == 0);
+                i += 7;
+                ++done;
+            }
+            reads.fetch_add(done);
+            if(sink < 0) std::cout << "";
+        });
+    }
+    threads.emplace_back([&]{
+        std::mt19937 gen{readers};
+        while(!stop.load(std::memory_order_relaxed)){
+            write(random_sequence(gen, 12));
+            std::this_thread::sleep_for(std::chrono::microseconds(writer_pause));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    stop.store(true);
+    for(auto& th : threads) th.join();
+    return reads.load() * 1000.0 / ms;
+}
+
+int main(int argc, char** argv){
+    unsigned max_threads = argc > 1 ? std::stoul(argv[1]) : std::thread::hardware_concurrency();
+    unsigned ms = argc > 2 ? std::stoul(argv[2]) : 500;
+    unsigned writer_pause = argc > 3 ? std::stoul(argv[3]) : 100;
+    if(max_threads == 0) max_threads = 1;
+
+    // Both tries are built once from the keys: a copy of a trie<char> this size is slow
+    std::mt19937 gen{42};
+    std::vector<std::vector<char>> keys;
+    for(unsigned i = 0; i < 50000; ++i) keys.push_back(random_sequence(gen, 10));
+    locked_trie locked;
+    for(std::size_t i = 0; i < keys.size(); ++i) insert_sequence(locked.t, keys[i], i % 97);
+    concurrent_trie<char> shared;
+    shared.update([&keys](trie<char>& t){
+        for(std::size_t i = 0; i < keys.size(); ++i) insert_sequence(t, keys[i], i % 97);
+    });
+
+    // Powers of two below max_threads, then max_threads
+    std::vector<unsigned> counts;
+    for(unsigned readers = 1; readers < max_threads; readers *= 2) counts.push_back(readers);
+    counts.push_back(max_threads);
+
+    std::cout << "readers\tmutex(reads/s)\tconcurrent(reads/s)\n";
+    for(unsigned readers : counts){
+        double with_mutex = run(readers, ms, writer_pause, keys,
+            [&](std::vector<char> const& k, bool scan){
+                std::lock_guard<std::mutex> lock{locked.lock};
+                trie<char> const& t = locked.t;
+                return scan ? t[prefix(k)].max().get_weight() : t[k].get_weight();
+            },
+            [&](std::vector<char> const& s){
+                std::lock_guard<std::mutex> lock{locked.lock};
+                insert_sequence(locked.t, s, 1.0);
+            });
+
+        double lock_free = run(readers, ms, writer_pause, keys,
+            [&](std::vector<char> const& k, bool scan){
+                auto guard = shared.read();
+                return scan ? (*guard)[prefix(k)].max().get_weight() : (*guard)[k].get_weight();
+            },
+            [&](std::vector<char> const& s){
+                shared.insert(s, 1.0);
+            });
+        std::cout << readers << "\t" << with_mutex << "\t" << lock_free << "\n";
+    }
+    return 0;
+}
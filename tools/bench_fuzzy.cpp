@@ -0,0 +1,80 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/trie.cpp"
+#include "../src/trie_search.cpp"
+
+/*
+ * Queries per second of fuzzy_search at edit distance 1 and 2.
+ * The trie is read from a .tr file of trie<char>, or built from random
+ * words when no file is given; queries are words of the trie with one
+ * random edit.
+ * usage: bench_fuzzy [file.tr] [queries]
+ */
+
+std::vector<std::vector<char>> leaves_of(trie<char> const& t){
+    std::vector<std::vector<char>> words;
+    std::vector<char> path;
+    std::vector<std::pair<trie<char> const*, bool>> stack{{&t, false}};
+    while(!stack.empty()){
+        auto top = stack.back();
+        stack.pop_back();
+        if(top.second){
+            path.pop_back();
+            continue;
+        }
+        if(top.first->get_label()){
+            path.push_back(*(top.first->get_label()));
+            stack.push_back({top.first, true});
+        }
+        if(top.first->get_children().empty()) words.push_back(path);
+        for(auto it = top.first->get_children().begin(); it != top.first->get_children().end(); ++it){
+            stack.push_back({&(*it), false});
+        }
+    }
+    return words;
+}
+
+int main(int argc, char** argv){
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    trie<char> t;
+    if(argc > 1){
+        std::ifstream file{argv[1]};
+        file >> t;
+    }else{
+        std::uniform_int_distribution<int> length{4, 10};
+        for(unsigned i = 0; i < 100000; ++i){
+            std::vector<char> w;
+            for(int l = length(gen); l > 0; --l) w.push_back(static_cast<char>(letter(gen)));
+            w.push_back('$');  // no word is a prefix of another one
+            insert_sequence(t, w, gen() % 1000);
+        }
+    }
+    unsigned queries = argc > 2 ? std::stoul(argv[2]) : 2000;
+
+    std::vector<std::vector<char>> words = leaves_of(t);
+    std::vector<std::vector<char>> batch;
+    for(unsigned i = 0; i < queries; ++i){
+        std::vector<char> q = words[gen() % words.size()];
+        std::size_t pos = gen() % q.size();
+        q[pos] = static_cast<char>(letter(gen));
+        batch.push_back(q);
+    }
+
+    std::cout << "edits\ttop_k\tqueries/s\tmatches/query\n";
+    for(std::size_t edits = 1; edits <= 2; ++edits){
+        for(std::size_t top_k : {std::size_t{0}, std::size_t{10}}){
+            std::size_t matches = 0;
+            auto start = std::chrono::steady_clock::now();
+            for(auto const& q : batch) matches += fuzzy_search(t, q, edits, top_k).size();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << edits << "\t" << top_k << "\t" << batch.size() / elapsed.count()
+                << "\t" << static_cast<double>(matches) / batch.size() << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../src/trie.cpp"
+#include "../src/trie_tokenizer.cpp"
+
+/*
+ * Throughput(MB/s) of the longest-match tokenizer on a trie<char> of
+ * random words: one thread with trie_tokenizer::tokenize(), then tokenize_batch() with
+ * 1..max threads. The documents are dictionary words separated by blanks
+ * and punctuation(unknown tokens).
+ * usage: bench_tokenize [words] [documents] [document_bytes] [max_threads]
+ */
+
+int main(int argc, char** argv){
+    unsigned words = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::size_t documents = argc > 2 ? std::stoul(argv[2]) : 2000;
+    std::size_t document_bytes = argc > 3 ? std::stoul(argv[3]) : 16384;
+    unsigned max_threads = argc > 4 ? std::stoul(argv[4]) : std::thread::hardware_concurrency();
+    if(max_threads == 0) max_threads = 1;
+
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> letter{'a', 'z'};
+    std::uniform_int_distribution<int> length{2, 10};
+    trie<char> t;
+    std::vector<std::vector<char>> inserted;
+    for(unsigned i = 0; i < words; ++i){
+        std::vector<char> w;
+        for(int l = length(gen); l > 0; --l) w.push_back(static_cast<char>(letter(gen)));
+        try{
+            insert_sequence(t, w, gen() % 1000);
+        }catch(parser_exception const&){
+            continue;  // prefix of a word already there
+        }
+        inserted.push_back(w);
+    }
+    // A word loses its leaf when a longer one goes below it
+    std::vector<std::string> dictionary;
+    for(auto const& w : inserted){
+        if(t[w].get_children().empty()) dictionary.emplace_back(w.begin(), w.end());
+    }
+    if(dictionary.empty()){
+        std::cerr << "No word in the dictionary\n";
+        return 1;
+    }
+
+    std::string separators = "  ,.;";
+    std::vector<std::string> batch(documents);
+    std::size_t bytes = 0;
+    for(auto& d : batch){
+        while(d.size() < document_bytes){
+            d += dictionary[gen() % dictionary.size()];
+            d += separators[gen() % separators.size()];
+        }
+        bytes += d.size();
+    }
+    double mb = bytes / 1e6;
+    std::cout << documents << " documents, " << mb << " MB, " << dictionary.size() << " words\n";
+
+    trie_tokenizer<char> tokenizer{t};
+    std::vector<trie_token> out;
+    std::size_t tokens = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(auto const& d : batch){
+        out.clear();
+        tokens += tokenizer.tokenize(d, out);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "threads\tMB/s\ttokens\n";
+    std::cout << "tokenize\t" << mb / elapsed.count() << "\t" << tokens << "\n";
+
+    // Powers of two below max_threads, then max_threads
+    std::vector<unsigned> counts;
+    for(unsigned threads = 1; threads < max_threads; threads *= 2) counts.push_back(threads);
+    counts.push_back(max_threads);
+    for(unsigned threads : counts){
+        thread_pool pool{threads};
+        start = std::chrono::steady_clock::now();
+        std::vector<std::vector<trie_token>> result = tokenizer.tokenize_batch(batch, pool);
+        elapsed = std::chrono::steady_clock::now() - start;
+        tokens = 0;
+        for(auto const& r : result) tokens += r.size();
+        std::cout << threads << "\t" << mb / elapsed.count() << "\t" << tokens << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../src/trie.cpp"
+#include "../src/trie_generator.cpp"
+
+/*
+ * Writes a synthetic .tr file, the same for the same options.
+ * usage: generate char|int|double|string [--option value]... [-o file]
+ * options(defaults in generator_options):
+ *     --seed N --leaves N --fanout N --zipf S --min-depth N --max-depth N
+ *     --chains P --chain-length N --wide P --wide-fanout N
+ *     --min-weight W --max-weight W --flat
+ * Without -o the trie is written on the standard output.
+ */
+
+template <typename T>
+void write(generator_options const& options, std::ostream& os){
+    trie_generator<T>{options}.write(os);
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::cerr << "usage: generate char|int|double|string [--option value]... [-o file]\n";
+        return 1;
+    }
+    std::string type = argv[1];
+    generator_options options;
+    std::string path;
+    try{
+        for(int i = 2; i < argc; ++i){
+            std::string name = argv[i];
+            if(name == "--flat"){
+                options.indent = false;
+                continue;
+            }
+            if(i + 1 >= argc) throw std::invalid_argument{"missing value of " + name};
+            std::string value = argv[++i];
+            if(name == "-o") path = value;
+            else if(name == "--seed") options.seed = std::stoull(value);
+            else if(name == "--leaves") options.leaves = std::stoull(value);
+            else if(name == "--fanout") options.max_fanout = std::stoull(value);
+            else if(name == "--zipf") options.zipf_s = std::stod(value);
+            else if(name == "--min-depth") options.min_depth = std::stoull(value);
+            else if(name == "--max-depth") options.max_depth = std::stoull(value);
+            else if(name == "--chains") options.chain_probability = std::stod(value);
+            else if(name == "--chain-length") options.chain_length = std::stoull(value);
+            else if(name == "--wide") options.wide_probability = std::stod(value);
+            else if(name == "--wide-fanout") options.wide_fanout = std::stoull(value);
+            else if(name == "--min-weight") options.min_weight = std::stod(value);
+            else if(name == "--max-weight") options.max_weight = std::stod(value);
+            else throw std::invalid_argument{"unknown option " + name};
+        }
+    }catch(std::exception const& e){
+        std::cerr << "generate: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if(!path.empty()){
+        file.open(path);
+        if(!file){
+            std::cerr << "generate: can't open " << path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& os = path.empty() ? std::cout : file;
+    if(type == "char") write<char>(options, os);
+    else if(type == "int") write<int>(options, os);
+    else if(type == "double") write<double>(options, os);
+    else if(type == "string") write<std::string>(options, os);
+    else{
+        std::cerr << "generate: unknown type " << type << "\n";
+        return 1;
+    }
+    return 0;
+}
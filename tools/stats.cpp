@@ -0,0 +1,42 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../src/trie.cpp"
+#include "../src/trie_stats.cpp"
+
+/*
+ * Prints the shape of the trie of a .tr file and recommendations.
+ * usage: stats char|int|double|string file.tr
+ */
+
+template <typename T>
+int report(std::istream& is){
+    trie<T> t;
+    is >> t;
+    std::cout << collect_stats(t);
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        std::cerr << "usage: stats char|int|double|string file.tr\n";
+        return 1;
+    }
+    std::string type = argv[1];
+    std::ifstream file{argv[2]};
+    if(!file){
+        std::cerr << "stats: can't open " << argv[2] << "\n";
+        return 1;
+    }
+    try{
+        if(type == "char") return report<char>(file);
+        if(type == "int") return report<int>(file);
+        if(type == "double") return report<double>(file);
+        if(type == "string") return report<std::string>(file);
+    }catch(parser_exception const& e){
+        std::cerr << "stats: " << e.what() << "\n";
+        return 1;
+    }
+    std::cerr << "stats: unknown type " << type << "\n";
+    return 1;
+}
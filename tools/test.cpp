@@ -3,13 +3,1506 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <unordered_set>
+// The hooks of trie.cpp and bag.hpp are defined only if it comes first
+#include "../src/trie_instrument.cpp"
 #include "../src/trie.cpp"
+#include "../src/trie_generator.cpp"
+#define TRIE_TRACK_ALLOCATIONS
+#include "../src/trie_memory.cpp"
+#include "../src/trie_stats.cpp"
+#include "../src/trie_hash.cpp"
+#include "../src/compact_trie.cpp"
+#include "../src/trie_parallel.cpp"
+#include "../src/concurrent_trie.cpp"
+#include "../src/persistent_trie.cpp"
+#include "../src/sharded_trie.cpp"
+#include "../src/trie_search.cpp"
+#include "../src/weight_index.cpp"
+#include "../src/aggregate_index.cpp"
+#include "../src/trie_events.cpp"
+#include "../src/lazy_trie.cpp"
+#include "../src/dawg.cpp"
+#include "../src/aho_corasick.cpp"
+#include "../src/trie_tokenizer.cpp"
+#include "../src/leaf_cursor.cpp"
 
 template <typename T>
 trie<T> foo(trie<T> a){
     return a;
 }
 
+// Checks of the extensions against trie<T>
+
+int failed_checks = 0;
+
+#define CHECK(cond) check_that((cond), #cond, __LINE__)
+
+void check_that(bool ok, char const* what, int line){
+    if(!ok){
+        ++failed_checks;
+        std::cerr << "test.cpp:" << line << ": check failed: " << what << "\n";
+    }
+}
+
+template <typename T>
+trie<T> parse_trie(std::string const& text){
+    std::istringstream is{text};
+    trie<T> t;
+    is >> t;
+    return t;
+}
+
+/** Sequences and weights of the leaves, in lexicographic order(the reference) */
+template <typename T>
+void reference_leaves(trie<T> const& t, std::vector<T>& path, std::vector<std::pair<std::vector<T>, double>>& leaves){
+    if(t.get_children().empty()){
+        leaves.push_back({path, t.get_weight()});
+        return;
+    }
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it){
+        path.push_back(*(it->get_label()));
+        reference_leaves(*it, path, leaves);
+        path.pop_back();
+    }
+}
+
+template <typename T>
+std::vector<std::pair<std::vector<T>, double>> reference_leaves(trie<T> const& t){
+    std::vector<T> path;
+    std::vector<std::pair<std::vector<T>, double>> leaves;
+    reference_leaves(t, path, leaves);
+    return leaves;
+}
+
+/** Random tries of the generator, with wide nodes and chains */
+template <typename T>
+std::vector<trie<T>> sample_tries(){
+    std::vector<trie<T>> samples;
+    samples.push_back(trie<T>{});
+    for(std::uint64_t seed = 1; seed <= 4; ++seed){
+        generator_options options;
+        options.seed = seed;
+        options.leaves = 300;
+        options.max_fanout = 6;
+        options.chain_probability = 0.1;
+        options.chain_length = 4;
+        options.wide_probability = seed % 2 ? 0.05 : 0.0;
+        options.wide_fanout = 80;
+        samples.push_back(generate_trie<T>(options));
+    }
+    return samples;
+}
+
+std::string const small_trie = "children = { a children = { b children = { a -1.5 children = {}, c 1.1 children = {} } }, c 0.5 children = {}, d -1.3 children = {} }";
+
+// compact_trie
+
+void test_compact_trie(){
+    std::vector<trie<char>> samples = sample_tries<char>();
+    samples.push_back(parse_trie<char>(small_trie));
+    for(auto const& t : samples){
+        compact_trie<char> c{t};
+        CHECK(c.expand() == t);
+        CHECK(c == compact_trie<char>{t});
+        auto leaves = reference_leaves(t);
+        auto it = c.begin();
+        for(auto const& l : leaves){
+            CHECK(it != c.end());
+            if(it == c.end()) break;
+            CHECK(it.get_leaf().get_weight() == l.second);
+            CHECK(c[l.first] == it.get_leaf());
+            ++it;
+        }
+        CHECK(it == c.end());
+        CHECK(c.max().get_weight() == t.max().get_weight());
+        std::vector<char> missing{'~', '~'};
+        CHECK(c[missing].get_weight() == t[missing].get_weight());
+        std::ostringstream a, b;
+        a << c;
+        b << t;
+        CHECK(a.str() == b.str());
+        compact_trie<char> reparsed;
+        std::istringstream is{a.str()};
+        is >> reparsed;
+        CHECK(reparsed == c);
+    }
+}
+
+// trie_parallel
+
+template <typename T>
+void check_parallel_parse(std::string const& text, thread_pool& pool){
+    trie<T> expected;
+    bool expected_error = false;
+    try{
+        expected = parse_trie<T>(text);
+    }catch(parser_exception const&){
+        expected_error = true;
+    }
+    for(unsigned split_depth : {0u, 1u, 3u}){
+        trie<T> t;
+        bool error = false;
+        try{
+            parallel_parse(text, t, pool, split_depth);
+        }catch(parser_exception const&){
+            error = true;
+        }
+        CHECK(error == expected_error);
+        if(!error && !expected_error) CHECK(t == expected);
+    }
+}
+
+std::string read_file(std::string const& name){
+    std::ifstream file{name};
+    return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+void test_parallel_parse(){
+    thread_pool pool{3};
+    for(auto name : {"final_test_ok", "test_leaf_ok", "test_root_no_leaf_ok", "trie_char1", "trie_char_error1",
+            "trie_char_error2", "trie_char_error3", "trie_char_error4", "trie_char_error5"}){
+        check_parallel_parse<char>(read_file(std::string{"datasets/"} + name + ".tr"), pool);
+    }
+    for(auto name : {"trie_string", "trie_string_error1", "trie_string_error2", "trie_string_error3", "trie_string_error4"}){
+        check_parallel_parse<std::string>(read_file(std::string{"datasets/"} + name + ".tr"), pool);
+    }
+    for(auto const& t : sample_tries<std::string>()){
+        std::ostringstream os;
+        os << t;
+        check_parallel_parse<std::string>(os.str(), pool);
+        // Malformed: a trie where a children list is expected
+        check_parallel_parse<std::string>("children = {" + os.str() + "}", pool);
+    }
+    // Duplicated labels in different chunks
+    std::string wide = "children = {";
+    for(int i = 0; i < 200; ++i) wide += "k" + std::to_string(i) + " 1 children = {}, ";
+    check_parallel_parse<std::string>(wide + "k1 2 children = {} }", pool);
+    check_parallel_parse<std::string>(wide + "k200 2 children = {} }", pool);
+    check_parallel_parse<char>("children = { a 1 children = {}, b 2 children = {}, a 3 children = {} }", pool);
+
+    std::istringstream is{read_file("datasets/final_test_ok.tr")};
+    trie<char> loaded;
+    parallel_load(is, loaded, 2);
+    CHECK(loaded == parse_trie<char>(read_file("datasets/final_test_ok.tr")));
+}
+
+void test_parallel_leaves(){
+    thread_pool pool{3};
+    std::vector<trie<std::string>> samples = sample_tries<std::string>();
+    samples.push_back(parse_trie<std::string>(read_file("datasets/trie_string.tr")));
+    for(auto& t : samples){
+        auto leaves = reference_leaves(t);
+        double sum = 0;
+        for(auto const& l : leaves) sum += l.second;
+        for(std::size_t grain : {std::size_t{1}, std::size_t{7}, std::size_t{4096}}){
+            std::mutex lock;
+            std::vector<trie<std::string> const*> visited;
+            parallel_for_each_leaf(static_cast<trie<std::string> const&>(t), [&](trie<std::string> const& leaf){
+                std::lock_guard<std::mutex> guard{lock};
+                visited.push_back(&leaf);
+            }, pool, grain);
+            CHECK(visited.size() == leaves.size());
+            std::sort(visited.begin(), visited.end());
+            CHECK(std::adjacent_find(visited.begin(), visited.end()) == visited.end());
+            CHECK(parallel_reduce(t, std::size_t{0}, [](trie<std::string> const&){ return std::size_t{1}; },
+                [](std::size_t a, std::size_t b){ return a + b; }, pool, grain) == leaves.size());
+        }
+        CHECK(parallel_leaf_count(t, pool) == leaves.size());
+        CHECK(std::abs(parallel_weight_sum(t, pool) - sum) <= 1e-9 * (1 + std::abs(sum)));
+        CHECK(&parallel_max(static_cast<trie<std::string> const&>(t), pool) == &t.max());
+        CHECK(&parallel_max(t, pool) == &t.max());
+
+        trie<std::string> copy{t};
+        parallel_for_each_leaf(copy, [](trie<std::string>& leaf){ leaf.set_weight(leaf.get_weight() + 1); }, pool);
+        auto shifted = reference_leaves(copy);
+        CHECK(shifted.size() == leaves.size());
+        for(std::size_t i = 0; i < shifted.size() && i < leaves.size(); ++i) CHECK(shifted[i].second == leaves[i].second + 1);
+    }
+}
+
+void test_parallel_merge(){
+    thread_pool pool{3};
+    std::vector<trie<std::string>> samples = sample_tries<std::string>();
+    samples.push_back(parse_trie<std::string>(read_file("datasets/trie_string.tr")));
+    samples.push_back(trie<std::string>{2.5});
+    for(auto const& a : samples){
+        for(auto const& b : samples){
+            trie<std::string> expected = a + b;
+            trie<std::string> dst{a};
+            trie<std::string> src{b};
+            CHECK(merge_into(dst, src) == expected);
+            for(unsigned split_depth : {1u, 4u}){
+                trie<std::string> pdst{a};
+                trie<std::string> psrc{b};
+                // The result is complete on return
+                CHECK(&merge_into(pdst, psrc, pool, split_depth) == &pdst);
+                CHECK(pdst == expected);
+            }
+        }
+    }
+    for(unsigned split_depth : {0u, 2u, 5u}){
+        std::vector<trie<std::string>> shards{samples};
+        trie<std::string> expected = samples[0];
+        for(std::size_t i = 1; i < samples.size(); ++i) expected = expected + samples[i];
+        CHECK(merge_all(shards, pool, split_depth) == expected);
+    }
+    std::vector<trie<std::string>> none;
+    CHECK(merge_all(none, pool) == trie<std::string>{});
+}
+
+// concurrent_trie
+
+void test_concurrent_trie(){
+    trie<char> expected = parse_trie<char>(small_trie);
+    concurrent_trie<char> c{expected, 4};
+    CHECK(*(c.read()) == expected);
+
+    insert_sequence(expected, {'x', 'y'}, 4.0);
+    c.insert({'x', 'y'}, 4.0);
+    CHECK(*(c.read()) == expected);
+
+    // Staged updates are seen only after publish()
+    c.stage([](trie<char>& t){ insert_sequence(t, {'z'}, 1.0); });
+    CHECK(c.pending() == 1);
+    CHECK(*(c.read()) == expected);
+    insert_sequence(expected, {'z'}, 1.0);
+
+    // An update throwing after a partial change is rolled back
+    bool thrown = false;
+    try{
+        c.stage([](trie<char>& t){
+            insert_sequence(t, {'q'}, 9.0);
+            throw parser_exception{"failed update"};
+        });
+    }catch(parser_exception const&){
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(c.pending() == 1);
+    c.publish();
+    CHECK(c.pending() == 0);
+    CHECK(*(c.read()) == expected);
+    // Both instances: the next publish shows the other one
+    c.update([](trie<char>& t){ t[{'c'}].set_weight(2.0); });
+    expected[{'c'}].set_weight(2.0);
+    CHECK(*(c.read()) == expected);
+    c.update([](trie<char>& t){ t[{'d'}].set_weight(3.0); });
+    expected[{'d'}].set_weight(3.0);
+    CHECK(*(c.read()) == expected);
+
+    // Readers while the writer publishes: every version has the first leaves
+    std::atomic<bool> stop{false};
+    std::atomic<unsigned> bad{0};
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 3; ++r){
+        readers.emplace_back([&]{
+            while(!stop.load()){
+                auto guard = c.read();
+                if((*guard)[{'a', 'b', 'c'}].get_weight() != 1.1) ++bad;
+            }
+        });
+    }
+    for(char l = 'e'; l < 'p'; ++l) c.insert({l}, 1.0);
+    stop.store(true);
+    for(auto& r : readers) r.join();
+    CHECK(bad.load() == 0);
+    CHECK(reference_leaves(*(c.read())).size() == reference_leaves(expected).size() + 11);
+}
+
+// persistent_trie
+
+void test_persistent_trie(){
+    std::vector<trie<char>> samples = sample_tries<char>();
+    samples.push_back(parse_trie<char>(small_trie));
+    for(auto const& t : samples){
+        persistent_trie<char> p{t};
+        CHECK(p.expand() == t);
+        auto leaves = reference_leaves(t);
+        for(auto const& l : leaves){
+            CHECK(p.contains(l.first));
+            CHECK(p.get_weight(l.first) == l.second);
+        }
+        // The cursor visits the leaves in order
+        std::size_t i = 0;
+        auto c = p.root();
+        while(true){
+            while(c.down_first()){}
+            CHECK(i < leaves.size() && c.sequence() == leaves[i].first && c.get_weight() == leaves[i].second);
+            ++i;
+            while(!c.next_sibling() && c.up()){}
+            if(c.depth() == 0) break;
+        }
+        CHECK(i == leaves.size());
+
+        // Updates make new versions, the old one is unchanged
+        std::vector<char> s = leaves.back().first;
+        persistent_trie<char> q = p.set_weight(s, -7.0);
+        CHECK(q.get_weight(s) == -7.0);
+        CHECK(p.get_weight(s) == leaves.back().second);
+        CHECK(p == persistent_trie<char>{t});
+        CHECK(q != p || leaves.back().second == -7.0);
+        CHECK(q.insert(s, 3.0).get_weight(s) == 3.0);
+        // As insert_sequence: an inner node can't get a weight
+        std::vector<char> inner{leaves.front().first};
+        bool thrown = false;
+        try{
+            if(!inner.empty()) inner.pop_back();
+            q.insert(inner, 1.0);
+        }catch(parser_exception const&){
+            thrown = true;
+        }
+        CHECK(thrown == !leaves.front().first.empty());
+    }
+    trie<char> t = parse_trie<char>(small_trie);
+    persistent_trie<char> p{t};
+    persistent_trie<char> q = p.insert({'a', 'x'}, 2.0);
+    insert_sequence(t, {'a', 'x'}, 2.0);
+    CHECK(q.expand() == t);
+    CHECK(!p.contains({'a', 'x'}));
+    CHECK(q.size() == p.size() + 1);
+
+    // Long chains: building, comparing, counting and destroying don't recurse
+    std::vector<char> chain(200000, 'c');
+    persistent_trie<char> deep = persistent_trie<char>{}.insert(chain, 1.0);
+    persistent_trie<char> deeper = deep.set_weight(chain, 2.0);
+    CHECK(deep.size() == chain.size() + 1);
+    CHECK(deep != deeper);
+    CHECK(deep == deep.set_weight(chain, 1.0));
+}
+
+// sharded_trie
+
+template <typename F>
+bool throws_parser_exception(F f){
+    try{
+        f();
+    }catch(parser_exception const&){
+        return true;
+    }
+    return false;
+}
+
+void test_sharded_trie(){
+    for(auto const& t : sample_tries<std::string>()){
+        auto leaves = reference_leaves(t);
+        if(leaves.size() == 1 && leaves[0].first.empty()) continue;
+        sharded_trie<std::string> sh{5};
+        // Producers insert interleaved parts of the leaves
+        std::vector<std::thread> producers;
+        for(unsigned p = 0; p < 3; ++p){
+            producers.emplace_back([&, p]{
+                for(std::size_t i = p; i < leaves.size(); i += 3) sh.insert(leaves[i].first, leaves[i].second);
+            });
+        }
+        for(auto& p : producers) p.join();
+
+        auto it = sh.begin();
+        for(auto const& l : leaves){
+            CHECK(sh.contains(l.first));
+            CHECK(sh.get_weight(l.first) == l.second);
+            CHECK(&sh[l.first] == &it.get_leaf());
+            CHECK(it != sh.end() && *it == l.first.back());
+            ++it;
+        }
+        CHECK(it == sh.end());
+        CHECK(sh.max().get_weight() == t.max().get_weight());
+        std::vector<std::string> prefix{leaves[0].first.front(), "no such label"};
+        CHECK(sh[prefix] == t[prefix] && *(sh[prefix].get_label()) == prefix.front());
+        // Deviations from trie<T>: no merged root to return
+        CHECK(throws_parser_exception([&]{ sh[std::vector<std::string>{}]; }));
+        CHECK(throws_parser_exception([&]{ sh[std::vector<std::string>{"no such label"}]; }));
+
+        trie<std::string> const* max = &sh.max();
+        trie<std::string> frozen = sh.freeze();
+        CHECK(frozen == t);
+        CHECK(frozen.max().get_weight() == max->get_weight());
+        CHECK(throws_parser_exception([&]{ sh.max(); }));
+        CHECK(sh.begin() == sh.end());
+    }
+}
+
+// trie_search
+
+template <typename T>
+std::size_t levenshtein(std::vector<T> const& a, std::vector<T> const& b){
+    std::vector<std::size_t> row(b.size() + 1);
+    for(std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for(std::size_t i = 1; i <= a.size(); ++i){
+        std::size_t diagonal = row[0];
+        row[0] = i;
+        for(std::size_t j = 1; j <= b.size(); ++j){
+            std::size_t up = row[j];
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + (a[i - 1] == b[j - 1] ? 0 : 1));
+            diagonal = up;
+        }
+    }
+    return row[b.size()];
+}
+
+/** Queries near the leaves: the leaves, their prefixes, edited copies and unknown labels */
+std::vector<std::vector<char>> sample_queries(std::vector<std::pair<std::vector<char>, double>> const& leaves){
+    std::vector<std::vector<char>> queries{{}, {'~'}, {'~', '~', '~'}};
+    for(std::size_t i = 0; i < leaves.size(); i += 37){
+        std::vector<char> s = leaves[i].first;
+        queries.push_back(s);
+        if(s.empty()) continue;
+        queries.push_back(std::vector<char>(s.begin(), s.end() - 1));
+        std::vector<char> changed = s;
+        changed[changed.size() / 2] = '~';
+        queries.push_back(changed);
+        changed.insert(changed.begin(), s.back());
+        queries.push_back(changed);
+    }
+    return queries;
+}
+
+void test_fuzzy_search(){
+    std::vector<trie<char>> samples = sample_tries<char>();
+    samples.push_back(parse_trie<char>(small_trie));
+    for(auto const& t : samples){
+        auto leaves = reference_leaves(t);
+        for(auto const& s : sample_queries(leaves)){
+            for(std::size_t edits = 0; edits <= 2; ++edits){
+                std::vector<trie_match<char>> expected;
+                for(auto const& l : leaves){
+                    std::size_t d = levenshtein(l.first, s);
+                    if(d <= edits) expected.push_back(trie_match<char>{nullptr, l.first, l.second, d});
+                }
+                auto found = fuzzy_search(t, s, edits);
+                CHECK(found.size() == expected.size());
+                for(std::size_t i = 0; i < found.size() && i < expected.size(); ++i){
+                    CHECK(found[i].sequence == expected[i].sequence);
+                    CHECK(found[i].distance == expected[i].distance);
+                    CHECK(found[i].weight == expected[i].weight);
+                    CHECK(&t[found[i].sequence] == found[i].leaf);
+                }
+                std::stable_sort(expected.begin(), expected.end(), [](trie_match<char> const& a, trie_match<char> const& b){
+                    return a.weight != b.weight ? a.weight > b.weight : a.distance < b.distance;
+                });
+                auto best = fuzzy_search(t, s, edits, 3);
+                CHECK(best.size() == std::min<std::size_t>(3, expected.size()));
+                for(std::size_t i = 0; i < best.size() && i < expected.size(); ++i) CHECK(best[i].sequence == expected[i].sequence);
+            }
+        }
+    }
+}
+
+/** If s matches the pattern from its token p(backtracking on the runs) */
+template <typename T>
+bool matches(std::vector<pattern_token<T>> const& pattern, std::size_t p, std::vector<T> const& s, std::size_t i){
+    if(p == pattern.size()) return i == s.size();
+    switch(pattern[p].kind){
+    case pattern_token<T>::any_run:
+        for(std::size_t j = i; j <= s.size(); ++j){
+            if(matches(pattern, p + 1, s, j)) return true;
+        }
+        return false;
+    case pattern_token<T>::any_one:
+        return i < s.size() && matches(pattern, p + 1, s, i + 1);
+    default:
+        return i < s.size() && s[i] == pattern[p].value && matches(pattern, p + 1, s, i + 1);
+    }
+}
+
+void test_pattern_search(){
+    using token = pattern_token<char>;
+    std::vector<trie<char>> samples = sample_tries<char>();
+    samples.push_back(parse_trie<char>(small_trie));
+    for(auto const& t : samples){
+        auto leaves = reference_leaves(t);
+        std::vector<std::vector<token>> patterns{{}, {token::run()}, {token::one()}, {token::one(), token::one(), token::run()}};
+        for(std::size_t i = 0; i < leaves.size(); i += 41){
+            std::vector<char> const& s = leaves[i].first;
+            if(s.empty()) continue;
+            std::vector<token> exact;
+            for(char c : s) exact.push_back(token::exact(c));
+            patterns.push_back(exact);
+            patterns.push_back({token::exact(s.front()), token::run()});
+            patterns.push_back({token::run(), token::exact(s.back())});
+            patterns.push_back({token::run(), token::exact(s[s.size() / 2]), token::run(), token::one()});
+            patterns.push_back({token::one(), token::run(), token::exact(s.back()), token::run()});
+        }
+        for(auto const& pattern : patterns){
+            std::vector<std::vector<char>> expected;
+            for(auto const& l : leaves){
+                if(matches(pattern, 0, l.first, 0)) expected.push_back(l.first);
+            }
+            std::vector<std::vector<char>> found;
+            for(auto it = pattern_search(t, pattern).begin(); it != pattern_iterator<char>{}; ++it){
+                found.push_back(it.sequence());
+                CHECK(&it.get_leaf() == &t[it.sequence()]);
+            }
+            CHECK(found == expected);
+        }
+    }
+    // Escapes and runs of make_pattern
+    std::vector<token> pattern = make_pattern("a\\*?**\\\\");
+    CHECK(pattern.size() == 5);
+    CHECK(pattern[0].kind == token::label && pattern[0].value == 'a');
+    CHECK(pattern[1].kind == token::label && pattern[1].value == '*');
+    CHECK(pattern[2].kind == token::any_one);
+    CHECK(pattern[3].kind == token::any_run);
+    CHECK(pattern[4].kind == token::label && pattern[4].value == '\\');
+}
+
+/** Number of leaves before it */
+template <typename Trie, typename Iterator>
+std::size_t leaf_position(Trie& t, Iterator it){
+    std::size_t n = 0;
+    for(auto i = t.begin(); i != it; ++i) ++n;
+    return n;
+}
+
+void test_range_search(){
+    std::vector<trie<char>> samples = sample_tries<char>();
+    samples.push_back(parse_trie<char>(small_trie));
+    for(auto& t : samples){
+        trie<char> const& ct = t;
+        auto leaves = reference_leaves(t);
+        std::vector<std::vector<char>> sequences;
+        for(auto const& l : leaves) sequences.push_back(l.first);
+        std::vector<std::vector<char>> queries = sample_queries(leaves);
+        queries.push_back({' '});
+        for(auto const& s : queries){
+            std::size_t lower = std::lower_bound(sequences.begin(), sequences.end(), s) - sequences.begin();
+            std::size_t upper = std::upper_bound(sequences.begin(), sequences.end(), s) - sequences.begin();
+            CHECK(leaf_position(t, lower_bound(t, s)) == lower);
+            CHECK(leaf_position(ct, lower_bound(ct, s)) == lower);
+            CHECK(leaf_position(t, upper_bound(t, s)) == upper);
+            CHECK(leaf_position(ct, upper_bound(ct, s)) == upper);
+            for(auto const& hi : {std::vector<char>{}, std::vector<char>{'~'}, sequences.back()}){
+                std::size_t end = std::lower_bound(sequences.begin(), sequences.end(), hi) - sequences.begin();
+                auto r = range(t, s, hi);
+                auto cr = range(ct, s, hi);
+                CHECK(leaf_position(t, r.first) == lower);
+                CHECK(leaf_position(ct, cr.first) == lower);
+                CHECK(leaf_position(t, r.second) == end);
+                CHECK(leaf_position(ct, cr.second) == end);
+            }
+        }
+    }
+}
+
+// weight_index
+
+/** Every inner node of t, root included */
+template <typename T>
+std::vector<trie<T> const*> inner_nodes(trie<T> const& t){
+    std::vector<trie<T> const*> nodes;
+    std::vector<trie<T> const*> stack{&t};
+    while(!stack.empty()){
+        trie<T> const* n = stack.back();
+        stack.pop_back();
+        if(n->get_children().empty()) continue;
+        nodes.push_back(n);
+        for(auto it = n->get_children().begin(); it != n->get_children().end(); ++it) stack.push_back(&(*it));
+    }
+    return nodes;
+}
+
+bool close_to(double a, double b){
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+}
+
+template <typename T>
+double reference_sum(trie<T> const& t){
+    double sum = 0;
+    for(auto const& l : reference_leaves(t)) sum += l.second;
+    return sum;
+}
+
+template <typename T>
+void check_weight_sums(weight_index<T> const& index, trie<T> const& t){
+    for(trie<T> const* n : inner_nodes(t)) CHECK(close_to(index.sum(*n), reference_sum(*n)));
+}
+
+void test_weight_index(){
+    std::vector<trie<std::string>> samples = sample_tries<std::string>();
+    for(std::size_t i = 1; i < samples.size(); ++i){
+        trie<std::string> t = samples[i];
+        weight_index<std::string> index{t};
+        check_weight_sums(index, t);
+
+        std::mt19937 rng{static_cast<unsigned>(i)};
+        trie<std::string> const& sub = *(inner_nodes(t).back());
+        for(trie<std::string> const* leaf : index.sample_n(sub, rng, 200)){
+            CHECK(leaf->get_children().empty() && leaf->get_weight() > 0);
+            trie<std::string> const* up = leaf;
+            while(up && up != &sub) up = up->get_parent();
+            CHECK(up == &sub);
+        }
+
+        // Updates through the index
+        std::size_t n = 0;
+        for(auto it = t.begin(); it != t.end(); ++it){
+            if(n++ % 7 == 0) index.set_weight(it.get_leaf(), n);
+        }
+        CHECK(throws_parser_exception([&]{ index.set_weight(t.begin().get_leaf(), -1.0); }));
+        check_weight_sums(index, t);
+        trie<std::string> const& other = samples[samples.size() - i];
+        trie<std::string> expected = t + other;
+        index += other;
+        CHECK(t == expected);
+        check_weight_sums(index, t);
+        index.rebuild();
+        check_weight_sums(index, t);
+        index.path_compress();
+        check_weight_sums(index, t);
+    }
+
+    // Frequencies of a small trie
+    trie<char> t = parse_trie<char>("children = { a 1 children = {}, b 3 children = {}, c 0 children = {}, d children = { e 0 children = {} } }");
+    weight_index<char> index{t};
+    std::mt19937 rng{7};
+    std::size_t b = 0;
+    for(trie<char> const* leaf : index.sample_n(rng, 20000)){
+        CHECK(*(leaf->get_label()) == 'a' || *(leaf->get_label()) == 'b');
+        if(*(leaf->get_label()) == 'b') ++b;
+    }
+    CHECK(b > 14500 && b < 15500);
+    CHECK(throws_parser_exception([&]{ index.sample(t[std::vector<char>{'d'}], rng); }));
+    CHECK(throws_parser_exception([]{
+        trie<char> negative = parse_trie<char>(small_trie);
+        weight_index<char> rejected{negative};
+    }));
+}
+
+// aggregate_index
+
+template <typename T>
+void check_aggregates(aggregate_index<T> const& index, aggregate_index<T, leaf_count_policy> const& counts, trie<T> const& t){
+    for(trie<T> const* n : inner_nodes(t)){
+        auto leaves = reference_leaves(*n);
+        subtree_aggregates a = index.get(*n);
+        CHECK(a.count == leaves.size() && counts.get(*n) == leaves.size());
+        CHECK(close_to(a.sum, reference_sum(*n)));
+        double min = leaves.front().second;
+        double max = leaves.front().second;
+        for(auto const& l : leaves){
+            min = std::min(min, l.second);
+            max = std::max(max, l.second);
+        }
+        CHECK(a.min == min && a.max == max);
+    }
+}
+
+void test_aggregate_index(){
+    std::vector<trie<std::string>> samples = sample_tries<std::string>();
+    samples.push_back(parse_trie<std::string>(small_trie));
+    for(std::size_t i = 1; i < samples.size(); ++i){
+        trie<std::string> t = samples[i];
+        aggregate_index<std::string> index{t};
+        aggregate_index<std::string, leaf_count_policy> counts{t};
+        check_aggregates(index, counts, t);
+        auto leaves = reference_leaves(t);
+        std::vector<std::string> prefix{leaves.back().first.front()};
+        CHECK(index.get(prefix).count == reference_leaves(t[prefix]).size());
+        prefix.push_back("no such label");
+        CHECK(index.get(prefix).count == 0 && index.get(prefix).max == weight_max_policy::identity());
+
+        // Mutations through the index
+        std::size_t n = 0;
+        for(auto it = t.begin(); it != t.end(); ++it){
+            if(n++ % 5 == 0) index.set_weight(it.get_leaf(), -static_cast<double>(n));
+        }
+        counts.rebuild();
+        check_aggregates(index, counts, t);
+        std::string label = "added";
+        trie<std::string> child = parse_trie<std::string>("children = { x 2.5 children = {}, y 5 children = {} }");
+        child.set_label(&label);
+        trie<std::string>& parent = const_cast<trie<std::string>&>(*(inner_nodes(t).back()));
+        index.add_child(parent, child);
+        counts.refresh(parent);
+        check_aggregates(index, counts, t);
+        trie<std::string>& leaf = t.begin().get_leaf();
+        index.add_child(leaf, child);
+        counts.refresh(leaf);
+        check_aggregates(index, counts, t);
+        trie<std::string> const& other = samples[samples.size() - i];
+        index += other;
+        counts.rebuild();
+        check_aggregates(index, counts, t);
+        index.path_compress();
+        counts.rebuild();
+        check_aggregates(index, counts, t);
+        // A change made without the index
+        trie<std::string>& last = const_cast<trie<std::string>&>(*(inner_nodes(t).back()));
+        last.get_children().begin()->set_weight(1e6);
+        index.refresh(last);
+        check_aggregates(index, counts, t);
+    }
+}
+
+// trie_events
+
+/* labels that are separators of the grammar, and a weight right after a label */
+std::string const separator_labels = "children = { , 1 children = {}, a1.0 children = {}, = -2 children = {}, { children = { } 3 children = {} } }";
+
+/** Inputs accepted or rejected by operator>>, with labels its grammar allows */
+std::vector<std::string> event_inputs_char(){
+    std::vector<std::string> inputs;
+    for(auto name : {"final_test_ok", "test_leaf_ok", "test_root_no_leaf_ok", "trie_char1", "trie_char_error1",
+            "trie_char_error2", "trie_char_error3", "trie_char_error4", "trie_char_error5"}){
+        inputs.push_back(read_file(std::string{"datasets/"} + name + ".tr"));
+    }
+    for(auto const& t : sample_tries<char>()){
+        std::ostringstream os;
+        os << t;
+        inputs.push_back(os.str());
+    }
+    inputs.push_back(small_trie);
+    inputs.push_back(separator_labels);
+    inputs.push_back("children={a 1 children={}}");
+    inputs.push_back("children = { a 1 children = {} } }");
+    inputs.push_back("children = { a 1 children = {}, a 2 children = {} }");
+    inputs.push_back("  2.5e1 children = {}  ");
+    inputs.push_back("children = { a 1 children = {}");
+    return inputs;
+}
+
+std::vector<std::string> event_inputs_string(){
+    std::vector<std::string> inputs;
+    for(auto name : {"trie_string", "trie_string_error1", "trie_string_error2", "trie_string_error3", "trie_string_error4"}){
+        inputs.push_back(read_file(std::string{"datasets/"} + name + ".tr"));
+    }
+    for(auto const& t : sample_tries<std::string>()){
+        std::ostringstream os;
+        os << t;
+        inputs.push_back(os.str());
+    }
+    inputs.push_back("children = { a{b,c=d} 1 children = {}, x, children = { y} 2 children = {} } }");
+    return inputs;
+}
+
+/* counts the events and checks that they nest */
+template <typename T>
+struct event_counter {
+    void on_enter(T const&){ ++entered; ++open; }
+    void on_leaf(T const*, double){ ++leaves; }
+    void on_exit(){ CHECK(open > 0); --open; }
+
+    std::size_t entered = 0;
+    std::size_t open = 0;
+    std::size_t leaves = 0;
+};
+
+template <typename T>
+void check_event_parse(std::string const& text){
+    trie<T> expected;
+    bool expected_error = false;
+    try{
+        expected = parse_trie<T>(text);
+    }catch(parser_exception const&){
+        expected_error = true;
+    }
+    trie<T> t;
+    trie_builder<T> builder{t};
+    std::istringstream is{text};
+    bool error = false;
+    try{
+        parse_events<T>(is, builder);
+    }catch(parser_exception const&){
+        error = true;
+    }
+    CHECK(error == expected_error);
+    if(error || expected_error) return;
+    CHECK(t == expected);
+    event_counter<T> counter;
+    std::istringstream again{text};
+    parse_events<T>(again, counter);
+    CHECK(counter.open == 0);
+    CHECK(counter.leaves == reference_leaves(expected).size());
+    CHECK(counter.entered + 1 == inner_nodes(expected).size() || (counter.entered == 0 && inner_nodes(expected).empty()));
+}
+
+void test_event_parser(){
+    for(auto const& text : event_inputs_char()) check_event_parse<char>(text);
+    for(auto const& text : event_inputs_string()) check_event_parse<std::string>(text);
+    CHECK(reference_leaves(parse_trie<char>(separator_labels)).size() == 4);
+}
+
+/**
+ * Feeds text in chunks of the given sizes(cycled) and compares with operator>>
+ * @return If the parser was done before finish()
+*/
+template <typename T>
+bool check_incremental_parse(std::string const& text, std::vector<std::size_t> const& chunks){
+    trie<T> expected;
+    bool expected_error = false;
+    try{
+        expected = parse_trie<T>(text);
+    }catch(parser_exception const&){
+        expected_error = true;
+    }
+    incremental_parser<T> parser;
+    trie<T> t;
+    bool error = false;
+    bool done = false;
+    try{
+        std::size_t begin = 0;
+        for(std::size_t i = 0; begin < text.size(); ++i){
+            std::size_t size = std::min(chunks[i % chunks.size()], text.size() - begin);
+            parser.feed(text.data() + begin, size);
+            begin += size;
+        }
+        done = parser.done();
+        t = parser.finish();
+    }catch(parser_exception const&){
+        error = true;
+    }
+    CHECK(error == expected_error);
+    if(!error && !expected_error) CHECK(t == expected);
+    return done;
+}
+
+void test_incremental_parser(){
+    for(auto const& text : event_inputs_char()){
+        check_incremental_parse<char>(text, {1});
+        check_incremental_parse<char>(text, {7, 1, 64});
+    }
+    for(auto const& text : event_inputs_string()){
+        check_incremental_parse<std::string>(text, {3});
+        check_incremental_parse<std::string>(text, {4096});
+    }
+    // Every split point of two chunks
+    for(std::string const& text : {small_trie, separator_labels}){
+        for(std::size_t split = 0; split <= text.size(); ++split){
+            CHECK(check_incremental_parse<char>(text, {split == 0 ? text.size() : split, text.size()}));
+        }
+    }
+    // The trie grows while the input comes
+    incremental_parser<char> parser;
+    std::string head = small_trie.substr(0, small_trie.find("c 0.5"));
+    parser.feed(head.data(), head.size());
+    CHECK(!parser.done());
+    CHECK(reference_leaves(parser.partial()).size() == 2);
+    std::string tail = small_trie.substr(head.size()) + "  \n";
+    parser.feed(tail.data(), tail.size());
+    CHECK(parser.done());
+    CHECK(parser.finish() == parse_trie<char>(small_trie));
+}
+
+// lazy_trie
+
+template <typename T>
+void check_lazy_trie(trie<T> const& t, std::size_t cache_records){
+    std::string const path = "build/test_lazy.tri";
+    {
+        std::ofstream os{path, std::ios::binary};
+        write_indexed(os, t);
+    }
+    lazy_trie<T> lazy{path, cache_records};
+    CHECK(lazy.root().materialize() == t);
+    auto leaves = reference_leaves(t);
+    auto it = lazy.begin();
+    for(auto const& l : leaves){
+        CHECK(it != lazy.end());
+        if(it == lazy.end()) break;
+        CHECK(it.get_leaf().get_weight() == l.second);
+        if(!l.first.empty()){
+            CHECK(*it == l.first.back());
+            auto found = lazy[l.first];
+            CHECK(found.is_leaf() && found.get_weight() == l.second && *(found.get_label()) == l.first.back());
+            CHECK(found.begin() == it);
+        }
+        ++it;
+    }
+    CHECK(it == lazy.end());
+    if(leaves.size() > 1) CHECK(lazy[leaves[0].first].begin() != lazy[leaves[1].first].begin());
+    CHECK(lazy.cached() <= std::max<std::size_t>(cache_records, 1));
+    auto max = lazy.max();
+    CHECK(max.get_weight() == t.max().get_weight());
+    CHECK(max.get_label() == nullptr ? t.max().get_label() == nullptr : *(max.get_label()) == *(t.max().get_label()));
+}
+
+void test_lazy_trie(){
+    for(auto const& t : sample_tries<char>()){
+        check_lazy_trie(t, 4096);
+        check_lazy_trie(t, 2);
+    }
+    for(auto const& t : sample_tries<std::string>()) check_lazy_trie(t, 3);
+    check_lazy_trie(parse_trie<char>(separator_labels), 1);
+    // Labels that text with default precision or blanks would not give back
+    trie<double> doubles;
+    insert_sequence(doubles, std::vector<double>{0.1234567891234, 2.0}, 1.5);
+    insert_sequence(doubles, std::vector<double>{0.1234567891235, -0.0}, 2.5);
+    insert_sequence(doubles, std::vector<double>{1e-300}, -1.0);
+    check_lazy_trie(doubles, 2);
+    trie<std::string> strings;
+    insert_sequence(strings, std::vector<std::string>{"a b", "c"}, 1.0);
+    insert_sequence(strings, std::vector<std::string>{"a", "b c"}, 2.0);
+    insert_sequence(strings, std::vector<std::string>{"", "\n{,}"}, 3.0);
+    check_lazy_trie(strings, 1);
+    std::remove("build/test_lazy.tri");
+}
+
+// trie_generator
+
+/** Depths of the leaves of t */
+template <typename T>
+std::vector<std::size_t> leaf_depths(trie<T> const& t){
+    std::vector<std::size_t> depths;
+    for(auto const& l : reference_leaves(t)) depths.push_back(l.first.size());
+    return depths;
+}
+
+template <typename T>
+void check_generated(generator_options const& options, bool exact_depth){
+    std::ostringstream a, b;
+    trie_generator<T> g{options};
+    g.write(a);
+    g.write(b);
+    CHECK(a.str() == b.str());
+    trie<T> t = parse_trie<T>(a.str());
+    CHECK(t == generate_trie<T>(options));
+    auto leaves = reference_leaves(t);
+    CHECK(leaves.size() == options.leaves);
+    for(auto const& l : leaves){
+        CHECK(l.second >= options.min_weight && l.second <= options.max_weight);
+        CHECK(std::abs(l.second * 100 - std::round(l.second * 100)) < 1e-6);
+    }
+    for(std::size_t d : leaf_depths(t)){
+        CHECK(d >= options.min_depth);
+        if(exact_depth) CHECK(d <= options.max_depth);
+    }
+    generator_options flat = options;
+    flat.indent = false;
+    CHECK(generate_trie<T>(flat) == t);
+    generator_options other = options;
+    ++other.seed;
+    CHECK(!(generate_trie<T>(other) == t));
+}
+
+void test_generator(){
+    generator_options options;
+    options.leaves = 400;
+    options.min_depth = 2;
+    options.max_depth = 5;
+    // trie<char> has 90 labels: a last level with more leaves goes deeper
+    check_generated<char>(options, false);
+    check_generated<int>(options, true);
+    check_generated<double>(options, true);
+    check_generated<std::string>(options, true);
+    options.wide_probability = 0.3;
+    options.wide_fanout = 150;
+    options.zipf_s = 0.0;
+    options.min_weight = -5.0;
+    options.max_weight = 5.0;
+    check_generated<char>(options, false);
+    check_generated<std::string>(options, true);
+    // Chains hang below inner nodes and don't count in the depth
+    options.chain_probability = 1.0;
+    options.chain_length = 3;
+    trie<std::string> chained = generate_trie<std::string>(options);
+    CHECK(reference_leaves(chained).size() == options.leaves);
+    std::vector<std::size_t> depths = leaf_depths(chained);
+    CHECK(*std::max_element(depths.begin(), depths.end()) > options.max_depth);
+    trie<std::string> compressed = chained;
+    compressed.path_compress();
+    CHECK(inner_nodes(compressed).size() < inner_nodes(chained).size());
+
+    // Large weights keep their two decimals, without an exponent
+    generator_options large;
+    large.leaves = 200;
+    large.min_weight = 1e5;
+    large.max_weight = 1e7;
+    check_generated<std::string>(large, true);
+    std::ostringstream text;
+    trie_generator<std::string>{large}.write(text);
+    std::istringstream lines{text.str()};
+    std::vector<double> written;
+    for(std::string line; std::getline(lines, line);){
+        std::size_t end = line.find(" children = {}");
+        if(end == std::string::npos) continue;
+        std::size_t begin = line.rfind(' ', end - 1) + 1;
+        std::string w = line.substr(begin, end - begin);
+        CHECK(w.find('e') == std::string::npos && w.size() > 3 && w[w.size() - 3] == '.');
+        written.push_back(std::stod(w));
+    }
+    std::vector<double> parsed;
+    for(auto const& l : reference_leaves(parse_trie<std::string>(text.str()))) parsed.push_back(l.second);
+    std::sort(written.begin(), written.end());
+    std::sort(parsed.begin(), parsed.end());
+    CHECK(written.size() == large.leaves && written == parsed);
+    CHECK(written.back() > 1e6 && std::any_of(written.begin(), written.end(), [](double w){ return w != std::round(w); }));
+}
+
+// trie_memory
+
+template <typename T>
+void check_memory(trie<T> const& t){
+    memory_stats m = memory_usage(t);
+    std::size_t nodes = inner_nodes(t).size() + reference_leaves(t).size();
+    if(t.get_children().empty()) nodes = 1;
+    CHECK(m.nodes == nodes);
+    CHECK(m.labels == nodes - 1);
+    CHECK(m.node_bytes == nodes * sizeof(trie<T>));
+    CHECK(m.link_bytes == (nodes - 1) * (sizeof(bag_node_layout<T>) - sizeof(trie<T>)));
+    CHECK(m.label_bytes >= m.labels * sizeof(T));
+    CHECK(m.total_bytes() == m.node_bytes + m.link_bytes + m.label_bytes + m.slack_bytes);
+    // A copy keeps what memory_usage counts, but the root and the slack
+    allocation_scope scope;
+    {
+        trie<T> copy{t};
+        allocation_stats copied = scope.stats();
+        std::size_t footprint = m.node_bytes - sizeof(trie<T>) + m.link_bytes + m.label_bytes;
+        CHECK(copied.live_bytes() == static_cast<long long>(footprint));
+        CHECK(copied.peak_bytes >= footprint && copied.allocations >= 2 * (nodes - 1));
+    }
+    allocation_stats s = scope.stats();
+    CHECK(s.deallocations == s.allocations);
+    CHECK(s.live_bytes() == 0);
+}
+
+void test_memory(){
+    CHECK(allocations_tracked());
+    for(auto const& t : sample_tries<char>()) check_memory(t);
+    for(auto const& t : sample_tries<std::string>()) check_memory(t);
+    trie<std::string> long_labels;
+    insert_sequence(long_labels, std::vector<std::string>{std::string(100, 'a'), "b"}, 1.0);
+    check_memory(long_labels);
+    CHECK(memory_usage(long_labels).label_bytes > 100);
+    std::ostringstream os;
+    os << memory_usage(long_labels);
+    CHECK(os.str().find("trie_nodes 3\n") != std::string::npos);
+}
+
+// trie_instrument
+
+void test_instrument(){
+    trie<std::string> t = sample_tries<std::string>()[1];
+    trie<std::string> other = sample_tries<std::string>()[2];
+    auto leaves = reference_leaves(t);
+    trie_instrumentation& instruments = trie_instruments();
+    instruments.reset();
+    for(auto const& l : leaves) t[l.first];
+    trie_op_stats const& lookup = instruments[trie_op::lookup];
+    CHECK(lookup.calls == leaves.size());
+    CHECK(lookup.counters.nodes_visited >= leaves.size() && lookup.counters.label_comparisons >= leaves.size());
+    std::uint64_t bucketed = 0;
+    for(auto b : lookup.histogram) bucketed += b;
+    CHECK(bucketed == lookup.calls);
+    CHECK(lookup.percentile_ns(0.5) <= lookup.percentile_ns(0.99) && lookup.percentile_ns(0.99) <= lookup.percentile_ns(1.0));
+
+    // Nested and recursive calls are charged to the outermost one
+    t.max();
+    CHECK(instruments[trie_op::max].calls == 1);
+    CHECK(instruments[trie_op::leaf_next].calls > 0);
+    trie<std::string> sum = t + other;
+    CHECK(instruments[trie_op::merge].calls == 1);
+    CHECK(instruments[trie_op::merge].counters.allocations > 0);
+    sum.path_compress();
+    CHECK(instruments[trie_op::compress].calls == 1);
+    std::ostringstream printed;
+    printed << t;
+    parse_trie<std::string>(printed.str());
+    CHECK(instruments[trie_op::parse].calls == 1);
+
+    // Other threads have their own stats
+    std::thread([&]{ t[leaves.front().first]; }).join();
+    CHECK(instruments[trie_op::lookup].calls == leaves.size());
+    std::ostringstream os;
+    os << instruments;
+    CHECK(os.str().find("trie_lookup_calls " + std::to_string(leaves.size()) + "\n") != std::string::npos);
+    CHECK(os.str().find("trie_end_calls") == std::string::npos || instruments[trie_op::end].calls > 0);
+    instruments.reset();
+    CHECK(instruments[trie_op::lookup].calls == 0);
+}
+
+// trie_stats
+
+template <typename T>
+void shape_by_depth(trie<T> const& t, std::size_t depth, std::vector<std::size_t>& nodes, std::vector<std::size_t>& leaves){
+    if(depth >= nodes.size()){
+        nodes.resize(depth + 1, 0);
+        leaves.resize(depth + 1, 0);
+    }
+    ++nodes[depth];
+    if(t.get_children().empty()) ++leaves[depth];
+    for(auto it = t.get_children().begin(); it != t.get_children().end(); ++it) shape_by_depth(*it, depth + 1, nodes, leaves);
+}
+
+template <typename T>
+void check_stats(trie<T> const& t){
+    trie_stats s = collect_stats(t);
+    std::vector<std::size_t> nodes;
+    std::vector<std::size_t> leaves;
+    shape_by_depth(t, 0, nodes, leaves);
+    CHECK(s.nodes_by_depth == nodes && s.leaves_by_depth == leaves);
+    CHECK(s.max_depth + 1 == nodes.size());
+    std::size_t total = 0;
+    for(auto n : nodes) total += n;
+    CHECK(s.nodes == total);
+    CHECK(s.leaves == reference_leaves(t).size());
+    std::map<std::size_t, std::size_t> fanout;
+    for(trie<T> const* n : inner_nodes(t)){
+        std::size_t children = 0;
+        for(auto it = n->get_children().begin(); it != n->get_children().end(); ++it) ++children;
+        ++fanout[children];
+    }
+    CHECK(s.fanout == fanout);
+    std::size_t labels = 0;
+    for(auto const& l : s.label_sizes) labels += l.second;
+    CHECK(labels == s.nodes - 1);
+    CHECK(s.node_bytes == static_cast<std::size_t>(std::lround(memory_usage(t).bytes_per_node())));
+}
+
+/** path_compress removes the counted nodes(labels of a char chain are summed and can collide, strings are joined) */
+void check_compressible(trie<std::string> const& t){
+    trie_stats s = collect_stats(t);
+    trie<std::string> compressed = t;
+    compressed.path_compress();
+    trie_stats after = collect_stats(compressed);
+    CHECK(after.nodes == s.nodes - s.compressible());
+    CHECK(after.compressible() == 0 && after.chains.empty());
+    CHECK(after.leaves == s.leaves);
+}
+
+void test_stats(){
+    for(auto const& t : sample_tries<char>()) check_stats(t);
+    for(auto const& t : sample_tries<std::string>()){
+        check_stats(t);
+        check_compressible(t);
+    }
+    trie_stats single = collect_stats(trie<char>{});
+    CHECK(single.nodes == 1 && single.leaves == 1 && single.max_depth == 0 && single.compressible() == 0);
+
+    generator_options options;
+    options.leaves = 300;
+    options.chain_probability = 0.2;
+    options.chain_length = 3;
+    options.wide_probability = 0.5;
+    options.wide_fanout = 100;
+    trie<std::string> shaped = generate_trie<std::string>(options);
+    // A chain of 8 single-child nodes below the root(the copies of path_compress grow with the depth)
+    std::vector<std::string> chain;
+    for(char c = 'a'; c <= 'i'; ++c) chain.push_back(std::string{"~"} + c);
+    insert_sequence(shaped, chain, 1.0);
+    check_stats(shaped);
+    check_compressible(shaped);
+    trie_stats s = collect_stats(shaped);
+    CHECK(s.chains.rbegin()->first == 8);
+    std::vector<std::string> advice = recommendations(s);
+    auto advised = [&advice](std::string const& what){
+        return std::any_of(advice.begin(), advice.end(), [&what](std::string const& a){ return a.find(what) != std::string::npos; });
+    };
+    CHECK(advised("worth running") && advised("longest chain") && advised("more than 64 children"));
+    std::ostringstream os;
+    os << s;
+    CHECK(os.str().find("nodes " + std::to_string(s.nodes) + "\n") == 0);
+    CHECK(os.str().find("compressible " + std::to_string(s.compressible()) + "\n") != std::string::npos);
+    shaped.path_compress();
+    advice = recommendations(collect_stats(shaped));
+    CHECK(advised("path_compress would change nothing") && !advised("longest chain"));
+}
+
+// trie_hash
+
+/** Every sub-trie has the hash of a fresh computation */
+template <typename T>
+void check_hashes(hash_index<T> const& index, trie<T> const& t){
+    CHECK(index.hash() == hash_trie(t));
+    hash_index<T> fresh{const_cast<trie<T>&>(t)};
+    for(trie<T> const* n : inner_nodes(t)) CHECK(index.hash(*n) == hash_trie(*n) && fresh.hash(*n) == index.hash(*n));
+}
+
+void test_hash_index(){
+    std::vector<trie<std::string>> samples = sample_tries<std::string>();
+    samples.push_back(parse_trie<std::string>(small_trie));
+    std::unordered_set<trie<std::string>, trie_hasher<std::string>> distinct;
+    for(auto const& a : samples){
+        distinct.insert(a);
+        for(auto const& b : samples) CHECK((hash_trie(a) == hash_trie(b)) == (a == b));
+    }
+    CHECK(distinct.size() == samples.size());
+    // Same shape, other weight of the root or label of the node: operator== ignores them
+    trie<std::string> relabeled = samples.back();
+    std::string label = "ignored";
+    relabeled.set_label(&label);
+    relabeled.set_weight(42.0);
+    CHECK(relabeled == samples.back() && hash_trie(relabeled) == hash_trie(samples.back()));
+    trie<char> zero = parse_trie<char>("children = { a 0 children = {} }");
+    trie<char> negative_zero = parse_trie<char>("children = { a -0 children = {} }");
+    CHECK(zero == negative_zero && hash_trie(zero) == hash_trie(negative_zero));
+
+    for(std::size_t i = 1; i < samples.size(); ++i){
+        trie<std::string> t = samples[i];
+        trie<std::string> copy = t;
+        hash_index<std::string> index{t};
+        hash_index<std::string> copy_index{copy};
+        check_hashes(index, t);
+        CHECK(probably_equal(index, copy_index) && equal(index, copy_index));
+
+        // Mutations through the index
+        trie<std::string>& first = t.begin().get_leaf();
+        index.set_weight(first, first.get_weight() + 1.0);
+        check_hashes(index, t);
+        CHECK(!probably_equal(index, copy_index) && !equal(index, copy_index));
+        std::string added = "added";
+        trie<std::string> child = parse_trie<std::string>("children = { x 2.5 children = {}, y 5 children = {} }");
+        child.set_label(&added);
+        index.add_child(const_cast<trie<std::string>&>(*(inner_nodes(t).back())), child);
+        check_hashes(index, t);
+        index.add_child(t.begin().get_leaf(), child);
+        check_hashes(index, t);
+        index += samples[samples.size() - i];
+        check_hashes(index, t);
+        index.path_compress();
+        check_hashes(index, t);
+        CHECK(equal(index, copy_index) == (t == copy));
+        // A change made without the index
+        trie<std::string>& last = const_cast<trie<std::string>&>(*(inner_nodes(t).back()));
+        last.get_children().begin()->set_weight(1e6);
+        index.refresh(last);
+        check_hashes(index, t);
+        copy = t;
+        copy_index.rebuild();
+        CHECK(probably_equal(index, copy_index) && equal(index, copy_index));
+    }
+}
+
+// dawg
+
+template <typename T>
+void check_dawg(trie<T> const& t){
+    dawg<T> d = minimize(t);
+    CHECK(d.expand() == t);
+    CHECK(d.states() <= collect_stats(t).nodes && d.edges() + 1 >= d.states());
+    auto leaves = reference_leaves(t);
+    std::size_t n = 0;
+    for(auto it = d.begin(); it != d.end(); ++it, ++n){
+        CHECK(n < leaves.size() && it.sequence() == leaves[n].first && it.get_leaf().get_weight() == leaves[n].second);
+    }
+    CHECK(n == leaves.size());
+    for(auto const& l : leaves){
+        typename dawg<T>::node_ref reached = d[l.first];
+        CHECK(reached.is_leaf() && reached.get_weight() == l.second);
+        CHECK(l.first.empty() || *(reached.get_label()) == l.first.back());
+    }
+    CHECK(d.max().get_weight() == t.max().get_weight());
+    // Equal sub-tries share their state
+    auto path = [&t](trie<T> const* n){
+        std::vector<T> s;
+        for(; n != &t; n = n->get_parent()) s.insert(s.begin(), *(n->get_label()));
+        return s;
+    };
+    std::vector<trie<T> const*> inner = inner_nodes(t);
+    for(trie<T> const* a : inner) CHECK((d[path(a)] == d[path(inner.back())]) == (*a == *(inner.back())));
+}
+
+void test_dawg(){
+    for(auto const& t : sample_tries<char>()) check_dawg(t);
+    for(auto const& t : sample_tries<std::string>()) check_dawg(t);
+    // Suffixes with the same weights collapse, other weights don't
+    trie<char> shared = parse_trie<char>("children = { a children = { x 1 children = {}, y 1 children = {} }, b children = { x 1 children = {}, y 1 children = {} }, c children = { x 1 children = {}, y 2 children = {} } }");
+    dawg<char> d = minimize(shared);
+    check_dawg(shared);
+    CHECK(d.states() == 5);
+    CHECK((d[{'a'}] == d[{'b'}] && d[{'a'}] != d[{'c'}] && d[{'a', 'x'}] == d[{'c', 'x'}]));
+    CHECK((d[{'c', 'z'}] == d[{'c'}]));
+    CHECK(d.max().get_weight() == 2.0 && *(d.max().get_label()) == 'y');
+    dawg<char> empty;
+    CHECK(empty.expand() == trie<char>{} && empty.states() == 1 && empty.root().is_leaf());
+}
+
+// aho_corasick
+
+/** Dictionary sequences joined with labels of no sequence in between */
+template <typename T>
+std::vector<T> sample_text(std::vector<std::pair<std::vector<T>, double>> const& leaves, T const& noise, std::size_t pieces){
+    std::vector<T> text;
+    for(std::size_t i = 0; i < pieces && !leaves.empty(); ++i){
+        auto const& s = leaves[(i * 7919) % leaves.size()].first;
+        text.insert(text.end(), s.begin(), s.end());
+        if(i % 3 == 0) text.push_back(noise);
+        // Cut a sequence: its prefix can still end other matches
+        if(i % 5 == 0 && s.size() > 1) text.insert(text.end(), s.begin(), s.end() - 1);
+    }
+    return text;
+}
+
+/** Every (end, length) where a sequence of a leaf occurs, longest first at an end */
+template <typename T>
+std::vector<text_match> brute_force_matches(std::vector<std::pair<std::vector<T>, double>> const& leaves, std::vector<T> const& text){
+    std::vector<text_match> result;
+    for(std::size_t end = 1; end <= text.size(); ++end){
+        std::vector<text_match> here;
+        for(auto const& l : leaves){
+            std::size_t n = l.first.size();
+            if(n == 0 || n > end) continue;
+            if(std::equal(l.first.begin(), l.first.end(), text.begin() + (end - n))) here.push_back(text_match{end, n, l.second});
+        }
+        std::sort(here.begin(), here.end(), [](text_match const& a, text_match const& b){ return a.length > b.length; });
+        result.insert(result.end(), here.begin(), here.end());
+    }
+    return result;
+}
+
+bool same_matches(std::vector<text_match> const& a, std::vector<text_match> const& b){
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](text_match const& x, text_match const& y){
+        return x.end == y.end && x.length == y.length && x.weight == y.weight;
+    });
+}
+
+template <typename T>
+void check_aho_corasick(trie<T> const& t, T const& noise){
+    aho_corasick<T> automaton{t};
+    auto leaves = reference_leaves(t);
+    CHECK(automaton.states() == collect_stats(t).nodes);
+    CHECK(automaton.patterns() == (t.get_children().empty() ? 0 : leaves.size()));
+    std::vector<T> text = sample_text(leaves, noise, 200);
+    std::vector<text_match> expected = brute_force_matches(leaves, text);
+    CHECK(same_matches(automaton.find_all(text), expected));
+    CHECK(automaton.scan(text, [](text_match const&){}) == expected.size());
+    // The same stream in chunks
+    for(std::size_t chunk : {1, 3, 64}){
+        typename aho_corasick<T>::scanner sc = automaton.stream();
+        std::vector<text_match> found;
+        for(std::size_t i = 0; i < text.size(); i += chunk){
+            sc.feed(text.begin() + i, text.begin() + std::min(text.size(), i + chunk), [&found](text_match const& m){ found.push_back(m); });
+        }
+        CHECK(sc.offset() == text.size() && same_matches(found, expected));
+        sc.reset();
+        CHECK(sc.offset() == 0 && sc.feed(text.begin(), text.end(), [](text_match const&){}) == expected.size());
+    }
+}
+
+void test_aho_corasick(){
+    for(auto const& t : sample_tries<char>()) check_aho_corasick<char>(t, ' ');
+    for(auto const& t : sample_tries<std::string>()) check_aho_corasick<std::string>(t, "no such label");
+    // Matches inside matches, through the failure and output links
+    trie<char> nested = parse_trie<char>("children = { h children = { e 1 children = {}, i children = { s 2 children = {} } }, s children = { h children = { e 3 children = {} } }, e 4 children = {} }");
+    check_aho_corasick<char>(nested, '.');
+    aho_corasick<char> automaton{nested};
+    std::vector<text_match> found = automaton.find_all(std::string{"ushers"});
+    CHECK(same_matches(found, {{4, 3, 3.0}, {4, 2, 1.0}, {4, 1, 4.0}}));
+    CHECK(aho_corasick<char>{}.find_all(std::string{"text"}).empty() && aho_corasick<char>{}.patterns() == 0);
+}
+
+// trie_tokenizer
+
+/** Tokens of a text: a leaf sequence starting at a position, else one more unknown label */
+template <typename T>
+std::vector<trie_token> brute_force_tokens(std::vector<std::pair<std::vector<T>, double>> const& leaves, std::vector<T> const& text){
+    std::vector<trie_token> tokens;
+    std::size_t i = 0;
+    while(i < text.size()){
+        // No leaf sequence is a prefix of another: at most one starts here
+        auto entry = std::find_if(leaves.begin(), leaves.end(), [&](std::pair<std::vector<T>, double> const& l){
+            return !l.first.empty() && l.first.size() <= text.size() - i && std::equal(l.first.begin(), l.first.end(), text.begin() + i);
+        });
+        if(entry != leaves.end()){
+            tokens.push_back(trie_token{i, entry->first.size(), entry->second, true});
+            i += entry->first.size();
+        }else if(!tokens.empty() && !tokens.back().known){
+            ++(tokens.back().length);
+            ++i;
+        }else{
+            tokens.push_back(trie_token{i++, 1, 0.0, false});
+        }
+    }
+    return tokens;
+}
+
+bool same_tokens(std::vector<trie_token> const& a, std::vector<trie_token> const& b){
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](trie_token const& x, trie_token const& y){
+        return x.begin == y.begin && x.length == y.length && x.weight == y.weight && x.known == y.known;
+    });
+}
+
+template <typename T>
+void check_tokenizer(trie<T> const& t, T const& noise, thread_pool& pool){
+    trie_tokenizer<T> tokenizer{t};
+    auto leaves = reference_leaves(t);
+    CHECK(tokenizer.nodes() == collect_stats(t).nodes);
+    std::vector<std::vector<T>> documents;
+    for(std::size_t pieces : {0, 1, 10, 200}) documents.push_back(sample_text(leaves, noise, pieces));
+    documents.push_back(std::vector<T>(3, noise));
+    std::vector<std::vector<trie_token>> sequential;
+    for(auto const& d : documents){
+        std::vector<trie_token> out{trie_token{0, 0, 0.0, false}};  // tokens are appended
+        std::size_t n = tokenizer.tokenize(d, out);
+        CHECK(n + 1 == out.size());
+        out.erase(out.begin());
+        CHECK(same_tokens(out, brute_force_tokens(leaves, d)));
+        sequential.push_back(out);
+    }
+    for(std::size_t grain : {1, 50, 1 << 16}){
+        std::vector<std::vector<trie_token>> batch = tokenizer.tokenize_batch(documents, pool, grain);
+        CHECK(batch.size() == documents.size());
+        for(std::size_t i = 0; i < batch.size(); ++i) CHECK(same_tokens(batch[i], sequential[i]));
+    }
+}
+
+void test_tokenizer(){
+    thread_pool pool{3};
+    for(auto const& t : sample_tries<char>()) check_tokenizer<char>(t, ' ', pool);
+    for(auto const& t : sample_tries<std::string>()) check_tokenizer<std::string>(t, "no such label", pool);
+    trie<char> words = parse_trie<char>("children = { a children = { b 1 children = {}, c children = { d 2 children = {} } }, c 3 children = {} }");
+    trie_tokenizer<char> tokenizer{words};
+    std::vector<trie_token> out;
+    CHECK(tokenizer.tokenize(std::string{"abxxacdacc"}, out) == 6);
+    CHECK(same_tokens(out, {{0, 2, 1.0, true}, {2, 2, 0.0, false}, {4, 3, 2.0, true}, {7, 1, 0.0, false}, {8, 1, 3.0, true}, {9, 1, 3.0, true}}));
+    out.clear();
+    CHECK(trie_tokenizer<char>{}.tokenize(std::string{"text"}, out) == 1 && out.front().length == 4 && !out.front().known);
+    // A batch waits its own tasks only, not one of the pool that runs until the batch is done
+    std::atomic<bool> started{false};
+    std::atomic<bool> released{false};
+    pool.submit([&started, &released]{
+        started = true;
+        while(!released) std::this_thread::yield();
+    });
+    while(!started) std::this_thread::yield();
+    CHECK(tokenizer.tokenize_batch(std::vector<std::string>{"ab", "c", "x"}, pool, 1).size() == 3);
+    released = true;
+    pool.wait();
+}
+
+// leaf_cursor
+
+template <typename T>
+void check_leaf_cursor(trie<T> const& t){
+    auto leaves = reference_leaves(t);
+    leaf_cursor<T> cursor{t};
+    for(int pass = 0; pass < 2; ++pass){
+        std::size_t n = 0;
+        while(cursor.next()){
+            CHECK(n < leaves.size());
+            if(n >= leaves.size()) break;
+            sequence_view<T> s = cursor.sequence();
+            CHECK(s.to_vector() == leaves[n].first && std::equal(s.begin(), s.end(), leaves[n].first.begin()));
+            CHECK(cursor.depth() == s.size && s.empty() == leaves[n].first.empty());
+            CHECK(s.empty() || s[s.size - 1] == *(cursor.leaf().get_label()));
+            CHECK(cursor.weight() == leaves[n].second && cursor.leaf().get_children().empty());
+            ++n;
+        }
+        CHECK(n == leaves.size());
+        CHECK(!cursor.next() && cursor.depth() == 0 && throws_parser_exception([&cursor]{ cursor.leaf(); }));
+        cursor.reset();
+    }
+    // On a sub-trie, the sequences start below it
+    if(t.get_children().empty()) return;
+    trie<T> const& sub = *(t.get_children().begin());
+    leaf_cursor<T> below{sub};
+    for(auto const& l : reference_leaves(sub)){
+        CHECK(below.next() && below.sequence().to_vector() == l.first);
+    }
+    CHECK(!below.next());
+}
+
+void test_leaf_cursor(){
+    for(auto const& t : sample_tries<char>()) check_leaf_cursor(t);
+    for(auto const& t : sample_tries<std::string>()) check_leaf_cursor(t);
+    trie<std::string> chained = parse_trie<std::string>("children = { a children = { b children = { c 1 children = {} } }, d 2 children = {} }");
+    check_leaf_cursor(chained);
+    leaf_cursor<std::string> cursor{chained};
+    CHECK(cursor.next() && cursor.depth() == 3 && cursor.next() && cursor.depth() == 1 && cursor.sequence()[0] == "d");
+}
+
 int main(){
     /** TEST GETTERS E SETTERS */
     /*
@@ -473,5 +1966,37 @@ int main(){
     // std::cout << t2;
     // std::cout << "\nMAX: \n";
     // std::cout << t2.max();
-}
 
+    // ---------------------------------------------
+    // Extensions
+    test_compact_trie();
+    test_parallel_parse();
+    test_parallel_leaves();
+    test_parallel_merge();
+    test_concurrent_trie();
+    test_persistent_trie();
+    test_sharded_trie();
+    test_fuzzy_search();
+    test_pattern_search();
+    test_range_search();
+    test_weight_index();
+    test_aggregate_index();
+    test_event_parser();
+    test_incremental_parser();
+    test_lazy_trie();
+    test_generator();
+    test_memory();
+    test_instrument();
+    test_stats();
+    test_hash_index();
+    test_dawg();
+    test_aho_corasick();
+    test_tokenizer();
+    test_leaf_cursor();
+    if(failed_checks > 0){
+        std::cerr << failed_checks << " checks failed\n";
+        return 1;
+    }
+    std::cout << "\nAll checks passed\n";
+    return 0;
+}